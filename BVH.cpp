@@ -0,0 +1,342 @@
+#include "BVH.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace gps {
+
+    static float surfaceArea(const glm::vec3& lo, const glm::vec3& hi) {
+        glm::vec3 e = glm::max(hi - lo, glm::vec3(0.0f));
+        return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    void TriangleBVH::build(std::vector<Triangle> triangles) {
+        tris = std::move(triangles);
+        nodes.clear();
+        depth = 0;
+        if (tris.empty())
+            return;
+
+        std::vector<glm::vec3> centroids(tris.size());
+        for (size_t i = 0; i < tris.size(); i++)
+            centroids[i] = (tris[i].a + tris[i].b + tris[i].c) / 3.0f;
+
+        nodes.reserve(tris.size() * 2 / MAX_LEAF + 1);
+        buildNode(centroids, 0, (uint32_t)tris.size(), 1);
+    }
+
+    uint32_t TriangleBVH::buildNode(std::vector<glm::vec3>& centroids, uint32_t first, uint32_t count, uint32_t level) {
+        uint32_t index = (uint32_t)nodes.size();
+        nodes.push_back(Node());
+        depth = std::max(depth, level);
+
+        glm::vec3 lo(1e30f), hi(-1e30f);
+        glm::vec3 cLo(1e30f), cHi(-1e30f);
+        for (uint32_t i = first; i < first + count; i++) {
+            const Triangle& t = tris[i];
+            lo = glm::min(lo, glm::min(t.a, glm::min(t.b, t.c)));
+            hi = glm::max(hi, glm::max(t.a, glm::max(t.b, t.c)));
+            cLo = glm::min(cLo, centroids[i]);
+            cHi = glm::max(cHi, centroids[i]);
+        }
+        nodes[index].min = lo;
+        nodes[index].max = hi;
+        nodes[index].first = first;
+        nodes[index].count = count;
+
+        if (count <= MAX_LEAF)
+            return index;
+
+        // binned SAH over all three axes
+        float bestCost = 1e30f;
+        int bestAxis = -1;
+        float bestSplit = 0.0f;
+
+        for (int axis = 0; axis < 3; axis++) {
+            float extent = cHi[axis] - cLo[axis];
+            if (extent < 1e-6f) continue;
+
+            int binCount[BINS] = {};
+            glm::vec3 binLo[BINS], binHi[BINS];
+            for (int b = 0; b < BINS; b++) { binLo[b] = glm::vec3(1e30f); binHi[b] = glm::vec3(-1e30f); }
+
+            float scale = BINS / extent;
+            for (uint32_t i = first; i < first + count; i++) {
+                int b = std::min((int)((centroids[i][axis] - cLo[axis]) * scale), BINS - 1);
+                const Triangle& t = tris[i];
+                binCount[b]++;
+                binLo[b] = glm::min(binLo[b], glm::min(t.a, glm::min(t.b, t.c)));
+                binHi[b] = glm::max(binHi[b], glm::max(t.a, glm::max(t.b, t.c)));
+            }
+
+            // sweep from the right to get the area of every right side, then from the left
+            float rightArea[BINS];
+            int rightCount[BINS];
+            glm::vec3 rLo(1e30f), rHi(-1e30f);
+            int rCount = 0;
+            for (int b = BINS - 1; b > 0; b--) {
+                rLo = glm::min(rLo, binLo[b]);
+                rHi = glm::max(rHi, binHi[b]);
+                rCount += binCount[b];
+                rightArea[b] = surfaceArea(rLo, rHi);
+                rightCount[b] = rCount;
+            }
+
+            glm::vec3 lLo(1e30f), lHi(-1e30f);
+            int lCount = 0;
+            for (int b = 0; b < BINS - 1; b++) {
+                lLo = glm::min(lLo, binLo[b]);
+                lHi = glm::max(lHi, binHi[b]);
+                lCount += binCount[b];
+                if (lCount == 0 || rightCount[b + 1] == 0) continue;
+
+                float cost = lCount * surfaceArea(lLo, lHi) + rightCount[b + 1] * rightArea[b + 1];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = cLo[axis] + (b + 1) / scale;
+                }
+            }
+        }
+
+        // traversal cost 1, intersection cost 1 per triangle
+        float leafCost = (float)count;
+        float splitCost = 1.0f + bestCost / std::max(surfaceArea(lo, hi), 1e-12f);
+        if (bestAxis < 0 || (splitCost >= leafCost && count <= 16))
+            return index;
+
+        uint32_t mid = first;
+        for (uint32_t i = first; i < first + count; i++) {
+            if (centroids[i][bestAxis] < bestSplit) {
+                std::swap(tris[i], tris[mid]);
+                std::swap(centroids[i], centroids[mid]);
+                mid++;
+            }
+        }
+        if (mid == first || mid == first + count)
+            mid = first + count / 2;
+
+        buildNode(centroids, first, mid - first, level + 1);
+        uint32_t right = buildNode(centroids, mid, first + count - mid, level + 1);
+
+        nodes[index].first = right;
+        nodes[index].count = 0;
+        return index;
+    }
+
+    // Moller-Trumbore, two-sided
+    static bool rayTriangle(const glm::vec3& o, const glm::vec3& d, const Triangle& tri, float maxT, float& t) {
+        glm::vec3 e1 = tri.b - tri.a;
+        glm::vec3 e2 = tri.c - tri.a;
+        glm::vec3 p = glm::cross(d, e2);
+        float det = glm::dot(e1, p);
+        if (std::fabs(det) < 1e-12f) return false;
+
+        float invDet = 1.0f / det;
+        glm::vec3 s = o - tri.a;
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) return false;
+
+        glm::vec3 q = glm::cross(s, e1);
+        float v = glm::dot(d, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) return false;
+
+        float hitT = glm::dot(e2, q) * invDet;
+        if (hitT < 0.0f || hitT > maxT) return false;
+        t = hitT;
+        return true;
+    }
+
+    static float rayBox(const glm::vec3& o, const glm::vec3& inv, const glm::vec3& lo, const glm::vec3& hi, float maxT) {
+        float tEnter = 0.0f, tExit = maxT;
+        for (int k = 0; k < 3; k++) {
+            float t0 = (lo[k] - o[k]) * inv[k];
+            float t1 = (hi[k] - o[k]) * inv[k];
+            tEnter = std::max(tEnter, std::min(t0, t1));
+            tExit = std::min(tExit, std::max(t0, t1));
+        }
+        return tEnter <= tExit ? tEnter : 1e30f;
+    }
+
+    bool TriangleBVH::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& t) const {
+        if (nodes.empty())
+            return false;
+
+        glm::vec3 inv;
+        for (int k = 0; k < 3; k++)
+            inv[k] = 1.0f / (std::fabs(dir[k]) < 1e-12f ? (dir[k] < 0.0f ? -1e-12f : 1e-12f) : dir[k]);
+
+        float best = maxT;
+        bool found = false;
+
+        // each inner level pops one node and pushes two, so depth entries always suffice;
+        // very unbalanced SAH splits can go deeper than the inline array
+        uint32_t inlineStack[64];
+        std::vector<uint32_t> heapStack;
+        uint32_t* stack = inlineStack;
+        if (depth > 64) {
+            heapStack.resize(depth);
+            stack = heapStack.data();
+        }
+        int top = 0;
+        if (rayBox(origin, inv, nodes[0].min, nodes[0].max, best) < 1e30f)
+            stack[top++] = 0;
+
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    float hitT;
+                    if (rayTriangle(origin, dir, tris[i], best, hitT)) {
+                        best = hitT;
+                        found = true;
+                    }
+                }
+                continue;
+            }
+
+            // visit the nearer child first
+            uint32_t left = (uint32_t)(&node - nodes.data()) + 1;
+            uint32_t right = node.first;
+            float tLeft = rayBox(origin, inv, nodes[left].min, nodes[left].max, best);
+            float tRight = rayBox(origin, inv, nodes[right].min, nodes[right].max, best);
+
+            if (tLeft > tRight) { std::swap(left, right); std::swap(tLeft, tRight); }
+            if (tRight < 1e30f) stack[top++] = right;
+            if (tLeft < 1e30f) stack[top++] = left;
+        }
+
+        if (found) t = best;
+        return found;
+    }
+
+    bool TriangleBVH::sweepSphere(const glm::vec3& start, const glm::vec3& delta, float r, SweepHit& hit) const {
+        if (nodes.empty())
+            return false;
+
+        // every triangle the sphere can touch lies in the box around the whole path
+        glm::vec3 lo = glm::min(start, start + delta) - glm::vec3(r);
+        glm::vec3 hi = glm::max(start, start + delta) + glm::vec3(r);
+        auto overlaps = [&lo, &hi](const Node& n) {
+            return n.min.x <= hi.x && n.max.x >= lo.x && n.min.y <= hi.y && n.max.y >= lo.y
+                && n.min.z <= hi.z && n.max.z >= lo.z;
+        };
+
+        bool found = false;
+        uint32_t inlineStack[64];
+        std::vector<uint32_t> heapStack;
+        uint32_t* stack = inlineStack;
+        if (depth > 64) {
+            heapStack.resize(depth);
+            stack = heapStack.data();
+        }
+        int top = 0;
+        if (overlaps(nodes[0]))
+            stack[top++] = 0;
+
+        while (top > 0) {
+            uint32_t index = stack[--top];
+            const Node& node = nodes[index];
+
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++)
+                    if (sweepSphereTriangle(start, delta, r, tris[i], hit))
+                        found = true;
+                continue;
+            }
+
+            if (overlaps(nodes[node.first])) stack[top++] = node.first;
+            if (overlaps(nodes[index + 1])) stack[top++] = index + 1;
+        }
+        return found;
+    }
+
+    bool TriangleBVH::groundHeight(const glm::vec3& p, float radius, float maxDrop, float maxY, float& height) const {
+        // start the probes at maxY so the nearest hit of each is already the highest allowed one
+        const float top = std::min(p.y, maxY);
+        maxDrop -= p.y - top;
+        if (maxDrop < 0.0f)
+            return false;
+
+        const float o = radius * 0.7f;
+        const glm::vec3 probes[5] = {
+            glm::vec3(0.0f), glm::vec3(o, 0.0f, 0.0f), glm::vec3(-o, 0.0f, 0.0f),
+            glm::vec3(0.0f, 0.0f, o), glm::vec3(0.0f, 0.0f, -o)
+        };
+
+        bool found = false;
+        for (const glm::vec3& offset : probes) {
+            float t;
+            glm::vec3 origin(p.x + offset.x, top, p.z + offset.z);
+            if (raycast(origin, glm::vec3(0.0f, -1.0f, 0.0f), maxDrop, t)) {
+                float y = top - t;
+                if (!found || y > height) height = y;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void TriangleBVH::benchmark(int gridSize, int queryCount) {
+        typedef std::chrono::steady_clock clock;
+
+        // rolling terrain of gridSize x gridSize quads over 100 x 100 units
+        const float cell = 100.0f / gridSize;
+        auto heightAt = [](float x, float z) {
+            return 0.6f * std::sin(x * 0.35f) * std::cos(z * 0.27f) + 0.15f * std::sin(x * 2.1f + z * 1.7f);
+        };
+
+        std::vector<Triangle> terrain;
+        terrain.reserve((size_t)gridSize * gridSize * 2);
+        for (int z = 0; z < gridSize; z++) {
+            for (int x = 0; x < gridSize; x++) {
+                float x0 = x * cell, x1 = x0 + cell, z0 = z * cell, z1 = z0 + cell;
+                glm::vec3 a(x0, heightAt(x0, z0), z0), b(x1, heightAt(x1, z0), z0);
+                glm::vec3 c(x0, heightAt(x0, z1), z1), d(x1, heightAt(x1, z1), z1);
+                terrain.push_back(Triangle{ a, b, c });
+                terrain.push_back(Triangle{ b, d, c });
+            }
+        }
+
+        auto start = clock::now();
+        TriangleBVH bvh;
+        bvh.build(terrain);
+        double buildMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        uint32_t rng = 1234u;
+        auto random01 = [&rng]() {
+            rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+            return (rng & 0xFFFFFF) / float(0x1000000);
+        };
+
+        int hits = 0;
+        float maxError = 0.0f;
+        start = clock::now();
+        for (int i = 0; i < queryCount; i++) {
+            glm::vec3 p(1.0f + random01() * 98.0f, 2.5f, 1.0f + random01() * 98.0f);
+            float h;
+            if (bvh.raycast(p, glm::vec3(0.0f, -1.0f, 0.0f), 10.0f, h)) {
+                hits++;
+                maxError = std::max(maxError, std::fabs((p.y - h) - heightAt(p.x, p.z)));
+            }
+        }
+        double rayUs = std::chrono::duration<double, std::micro>(clock::now() - start).count() / queryCount;
+
+        start = clock::now();
+        for (int i = 0; i < queryCount; i++) {
+            glm::vec3 p(1.0f + random01() * 98.0f, 2.5f, 1.0f + random01() * 98.0f);
+            float h;
+            bvh.groundHeight(p, 0.35f, 10.0f, p.y, h);
+        }
+        double groundUs = std::chrono::duration<double, std::micro>(clock::now() - start).count() / queryCount;
+
+        std::cout << "Ground BVH: " << terrain.size() << " triangles, " << bvh.nodes.size() << " nodes, depth " << bvh.depth << std::endl;
+        std::cout << "  build: " << buildMs << " ms" << std::endl;
+        std::cout << "  single ray:   " << rayUs << " us (" << hits << "/" << queryCount
+            << " hits, max error vs. analytic height " << maxError << ")" << std::endl;
+        std::cout << "  groundHeight: " << groundUs << " us (5 rays)" << std::endl;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef BVH_hpp
+#define BVH_hpp
+
+#include <glm/glm.hpp>
+
+#include "Collision.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace gps {
+
+    // static bounding volume hierarchy over world-space triangles (binned SAH build).
+    // Built once at load time; queries are read-only and can run from several threads.
+    class TriangleBVH {
+
+    public:
+        void build(std::vector<Triangle> triangles);
+
+        // nearest hit along origin + dir * t for t in [0, maxT]
+        bool raycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, float& t) const;
+
+        // nearest hit of a moving sphere against the triangles near its path
+        bool sweepSphere(const glm::vec3& start, const glm::vec3& delta, float r, SweepHit& hit) const;
+
+        // height of the highest surface below p (within maxDrop) that is not above maxY,
+        // probing the centre and four points at radius so the player doesn't sink at
+        // the edge of a step; a bench or railing under one probe can't hide the floor
+        bool groundHeight(const glm::vec3& p, float radius, float maxDrop, float maxY, float& height) const;
+
+        size_t triangleCount() const { return tris.size(); }
+        bool empty() const { return nodes.empty(); }
+
+        // build time and ground queries per second on a generated terrain
+        static void benchmark(int gridSize, int queryCount);
+
+    private:
+        // 32 bytes; leaves store [first, first + count) in tris; inner nodes have count == 0,
+        // their left child right after them and the right child at index first
+        struct Node {
+            glm::vec3 min;
+            uint32_t first;
+            glm::vec3 max;
+            uint32_t count;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<Triangle> tris;
+        // levels of the deepest leaf; a traversal never holds more nodes than this
+        uint32_t depth = 0;
+
+        static const int MAX_LEAF = 4;
+        static const int BINS = 12;
+
+        uint32_t buildNode(std::vector<glm::vec3>& centroids, uint32_t first, uint32_t count, uint32_t level);
+    };
+}
+
+#endif /* BVH_hpp */
@@ -0,0 +1,143 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace gps {
+
+    void BenchmarkRecorder::release() {
+        if (queries[0][0])
+            glDeleteQueries(QUERY_RING * 2, &queries[0][0]);
+        std::fill(&queries[0][0], &queries[0][0] + QUERY_RING * 2, 0u);
+    }
+
+    void BenchmarkRecorder::init(int frameCount) {
+        frames.clear();
+        frames.reserve(frameCount);
+        if (!queries[0][0])
+            glGenQueries(QUERY_RING * 2, &queries[0][0]);
+        std::fill(pending, pending + QUERY_RING, 0);
+    }
+
+    void BenchmarkRecorder::beginFrame() {
+        int slot = (int)frames.size() % QUERY_RING;
+        // the slot was used QUERY_RING frames ago; its result is normally ready by now
+        if (pending[slot])
+            collect(slot);
+
+        frames.push_back(Frame());
+        pending[slot] = (int)frames.size();
+        glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+        cpuStart = std::chrono::steady_clock::now();
+    }
+
+    void BenchmarkRecorder::endFrame(const BenchmarkCounters& counters) {
+        Frame& f = frames.back();
+        f.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpuStart).count();
+        f.counters = counters;
+        glQueryCounter(queries[(frames.size() - 1) % QUERY_RING][1], GL_TIMESTAMP);
+    }
+
+    void BenchmarkRecorder::collect(int slot) {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(queries[slot][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(queries[slot][1], GL_QUERY_RESULT, &end);
+        frames[pending[slot] - 1].gpuMs = (double)(end - begin) / 1.0e6;
+        pending[slot] = 0;
+    }
+
+    void BenchmarkRecorder::finish() {
+        for (int slot = 0; slot < QUERY_RING; slot++)
+            if (pending[slot])
+                collect(slot);
+    }
+
+    void BenchmarkRecorder::setPassTimes(long long frame, const std::vector<GpuProfiler::PassTime>& passes) {
+        if (frame < 0 || frame >= (long long)frames.size())
+            return;
+
+        std::vector<double>& ms = frames[frame].passMs;
+        for (const GpuProfiler::PassTime& p : passes) {
+            size_t column = std::find(passNames.begin(), passNames.end(), p.name) - passNames.begin();
+            if (column == passNames.size())
+                passNames.push_back(p.name);
+            if (ms.size() <= column)
+                ms.resize(column + 1, -1.0);
+            // a pass drawn twice in a frame counts once with the sum
+            ms[column] = ms[column] < 0.0 ? p.ms : ms[column] + p.ms;
+        }
+    }
+
+    bool BenchmarkRecorder::writeCsv(const std::string& fileName) const {
+        std::ofstream out(fileName);
+        if (!out) {
+            std::cout << "ERROR: could not write " << fileName << std::endl;
+            return false;
+        }
+
+        out << "frame,cpu_ms,gpu_ms,meshes_drawn,meshes_culled,triangles,draw_calls,state_changes";
+        for (const std::string& name : passNames)
+            out << ",gpu_" << name << "_ms";
+        out << "\n";
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            const Frame& f = frames[i];
+            out << i << "," << f.cpuMs << "," << f.gpuMs << ","
+                << f.counters.meshesDrawn << "," << f.counters.meshesCulled << "," << f.counters.triangles
+                << "," << f.counters.drawCalls << "," << f.counters.stateChanges;
+            for (size_t p = 0; p < passNames.size(); p++)
+                out << "," << (p < f.passMs.size() ? f.passMs[p] : -1.0);
+            out << "\n";
+        }
+        return (bool)out;
+    }
+
+    static void printStats(const char* name, std::vector<double> values) {
+        if (values.empty()) return;
+
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (double v : values) sum += v;
+
+        // nearest rank
+        auto percentile = [&values](double p) {
+            size_t rank = (size_t)std::ceil(p / 100.0 * values.size());
+            return values[std::min(std::max(rank, (size_t)1), values.size()) - 1];
+        };
+
+        std::cout << "  " << name << " ms: mean " << sum / values.size()
+            << ", p50 " << percentile(50) << ", p95 " << percentile(95) << ", p99 " << percentile(99)
+            << ", max " << values.back() << std::endl;
+    }
+
+    void BenchmarkRecorder::printSummary() const {
+        std::vector<double> cpu, gpu;
+        double meshes = 0.0, culled = 0.0, triangles = 0.0, draws = 0.0;
+        for (const Frame& f : frames) {
+            cpu.push_back(f.cpuMs);
+            if (f.gpuMs >= 0.0) gpu.push_back(f.gpuMs);
+            meshes += f.counters.meshesDrawn;
+            culled += f.counters.meshesCulled;
+            triangles += (double)f.counters.triangles;
+            draws += f.counters.drawCalls;
+        }
+
+        std::cout << "Benchmark: " << frames.size() << " frames" << std::endl;
+        printStats("CPU", cpu);
+        printStats("GPU", gpu);
+
+        for (size_t p = 0; p < passNames.size(); p++) {
+            std::vector<double> pass;
+            for (const Frame& f : frames)
+                if (p < f.passMs.size() && f.passMs[p] >= 0.0) pass.push_back(f.passMs[p]);
+            printStats(("  GPU " + passNames[p]).c_str(), pass);
+        }
+        if (!frames.empty()) {
+            double n = (double)frames.size();
+            std::cout << "  per frame: " << meshes / n << " meshes drawn, " << culled / n << " culled, "
+                << triangles / n << " triangles, " << draws / n << " draw calls" << std::endl;
+        }
+    }
+}
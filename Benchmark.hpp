@@ -0,0 +1,69 @@
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include "GpuProfiler.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace gps {
+
+    struct BenchmarkCounters {
+        int meshesDrawn = 0;
+        int meshesCulled = 0;
+        long long triangles = 0;
+        int drawCalls = 0;     // GL draw calls seen by GLStats
+        int stateChanges = 0;
+    };
+
+    // per-frame CPU and GPU time plus draw counters for --benchmark runs.
+    // GPU time comes from a pair of GL_TIMESTAMP queries per frame in a small
+    // ring, read back a few frames later so the measurement never stalls.
+    class BenchmarkRecorder {
+
+    public:
+        void init(int frameCount);
+        // deletes the queries; needs the GL context
+        void release();
+        void beginFrame();
+        // cpu time ends here; call before the swap / finish of the frame
+        void endFrame(const BenchmarkCounters& counters);
+        // waits for the outstanding queries
+        void finish();
+
+        // per-pass GPU times of a recorded frame, from GpuProfiler
+        void setPassTimes(long long frame, const std::vector<GpuProfiler::PassTime>& passes);
+
+        bool writeCsv(const std::string& fileName) const;
+        void printSummary() const;
+
+    private:
+        static const int QUERY_RING = 4;
+
+        struct Frame {
+            double cpuMs = 0.0;
+            double gpuMs = -1.0; // -1 until the queries are read back
+            BenchmarkCounters counters;
+            std::vector<double> passMs; // by passNames, -1 = not measured
+        };
+
+        std::vector<Frame> frames;
+        std::vector<std::string> passNames;
+        GLuint queries[QUERY_RING][2] = {};
+        int pending[QUERY_RING] = {}; // frame index + 1 waiting in each slot, 0 = free
+        std::chrono::steady_clock::time_point cpuStart;
+
+        void collect(int slot);
+    };
+}
+
+#endif /* Benchmark_hpp */
@@ -19,6 +19,8 @@ namespace gps {
         void rotate(float pitch, float yaw);
         glm::vec3 getPosition() const { return cameraPosition; }
         void setPosition(const glm::vec3& p) { cameraPosition = p; }
+        glm::vec3 getFrontDirection() const { return cameraFrontDirection; }
+        glm::vec3 getUpDirection() const { return cameraUpDirection; }
 
     private:
         glm::vec3 cameraPosition;
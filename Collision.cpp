@@ -0,0 +1,613 @@
+#include "Collision.hpp"
+#include "BVH.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GPS_COLLISION_SIMD 1
+#endif
+
+namespace gps {
+
+    bool sphereIntersectsAABB(const glm::vec3& c, float r, const AABB& b)
+    {
+        glm::vec3 closest = glm::clamp(c, b.min, b.max);
+        glm::vec3 d = c - closest;
+        return glm::dot(d, d) < (r * r);
+    }
+
+    glm::vec3 resolveSphereAABB(glm::vec3 c, float r, const AABB& b)
+    {
+        glm::vec3 closest = glm::clamp(c, b.min, b.max);
+        glm::vec3 delta = c - closest;
+
+        if (glm::length(delta) < 1e-6f) {
+            float left = c.x - b.min.x;
+            float right = b.max.x - c.x;
+            float down = c.y - b.min.y;
+            float up = b.max.y - c.y;
+            float back = c.z - b.min.z;
+            float front = b.max.z - c.z;
+
+            float m = left; int axis = 0; float sign = -1.0f;
+            if (right < m) { m = right; axis = 0; sign = +1.0f; }
+            if (down < m) { m = down;  axis = 1; sign = -1.0f; }
+            if (up < m) { m = up;    axis = 1; sign = +1.0f; }
+            if (back < m) { m = back;  axis = 2; sign = -1.0f; }
+            if (front < m) { m = front; axis = 2; sign = +1.0f; }
+
+            if (axis == 0) c.x += sign * (r + 0.001f);
+            if (axis == 1) c.y += sign * (r + 0.001f);
+            if (axis == 2) c.z += sign * (r + 0.001f);
+            return c;
+        }
+
+        float dist = glm::length(delta);
+        glm::vec3 n = delta / dist;
+        float push = (r - dist) + 0.001f;
+        return c + n * push;
+    }
+
+    bool sweepSphereAABB(const glm::vec3& start, const glm::vec3& delta, float r, const AABB& b, SweepHit& hit)
+    {
+        glm::vec3 lo = b.min - glm::vec3(r);
+        glm::vec3 hi = b.max + glm::vec3(r);
+
+        // slab test of the centre's path against the grown box
+        float tEnter = -1e30f, tExit = 1e30f;
+        int axis = -1;
+        for (int k = 0; k < 3; k++) {
+            if (std::fabs(delta[k]) < 1e-12f) {
+                if (start[k] < lo[k] || start[k] > hi[k]) return false;
+                continue;
+            }
+            float inv = 1.0f / delta[k];
+            float t0 = (lo[k] - start[k]) * inv;
+            float t1 = (hi[k] - start[k]) * inv;
+            if (t0 > t1) std::swap(t0, t1);
+            if (t0 > tEnter) { tEnter = t0; axis = k; }
+            tExit = std::min(tExit, t1);
+        }
+
+        if (axis < 0 || tEnter > tExit || tExit < 0.0f)
+            return false;
+
+        glm::vec3 normal(0.0f);
+        if (tEnter < 0.0f) {
+            // starts inside the grown box (resting on it after a slide, or a rounding
+            // error): block motion through the nearest face, allow sliding along or away
+            float depth = 1e30f;
+            for (int k = 0; k < 3; k++) {
+                if (start[k] - lo[k] < depth) { depth = start[k] - lo[k]; normal = glm::vec3(0.0f); normal[k] = -1.0f; }
+                if (hi[k] - start[k] < depth) { depth = hi[k] - start[k]; normal = glm::vec3(0.0f); normal[k] = 1.0f; }
+            }
+            if (glm::dot(delta, normal) >= 0.0f)
+                return false;
+            tEnter = 0.0f;
+        }
+        else {
+            normal[axis] = delta[axis] > 0.0f ? -1.0f : 1.0f;
+        }
+
+        if (tEnter >= hit.t)
+            return false;
+
+        hit.t = tEnter;
+        hit.normal = normal;
+        hit.hit = true;
+        return true;
+    }
+
+    // Ericson, Real-Time Collision Detection 5.1.5
+    static glm::vec3 closestPointOnTriangle(const glm::vec3& p, const Triangle& tri)
+    {
+        glm::vec3 ab = tri.b - tri.a, ac = tri.c - tri.a, ap = p - tri.a;
+        float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return tri.a;
+
+        glm::vec3 bp = p - tri.b;
+        float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return tri.b;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return tri.a + ab * (d1 / (d1 - d3));
+
+        glm::vec3 cp = p - tri.c;
+        float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return tri.c;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return tri.a + ac * (d2 / (d2 - d6));
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return tri.b + (tri.c - tri.b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float denom = 1.0f / (va + vb + vc);
+        return tri.a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+    // first time in [0, maxT) where a*t^2 + b*t + c = 0; a sphere already touching (root < 0) is not a hit
+    static bool lowestRoot(float a, float b, float c, float maxT, float& root)
+    {
+        if (std::fabs(a) < 1e-12f) return false;
+        float det = b * b - 4.0f * a * c;
+        if (det < 0.0f) return false;
+
+        float sq = std::sqrt(det);
+        float r1 = (-b - sq) / (2.0f * a);
+        float r2 = (-b + sq) / (2.0f * a);
+        if (r1 > r2) std::swap(r1, r2);
+
+        if (r1 < 0.0f || r1 >= maxT) return false;
+        root = r1;
+        return true;
+    }
+
+    static bool pointInTriangle(const glm::vec3& p, const Triangle& tri, const glm::vec3& n)
+    {
+        return glm::dot(glm::cross(tri.b - tri.a, p - tri.a), n) >= 0.0f &&
+            glm::dot(glm::cross(tri.c - tri.b, p - tri.b), n) >= 0.0f &&
+            glm::dot(glm::cross(tri.a - tri.c, p - tri.c), n) >= 0.0f;
+    }
+
+    bool sweepSphereTriangle(const glm::vec3& start, const glm::vec3& delta, float r, const Triangle& tri, SweepHit& hit)
+    {
+        glm::vec3 n = glm::cross(tri.b - tri.a, tri.c - tri.a);
+        float area = glm::length(n);
+        if (area < 1e-12f) return false;
+        n = n / area;
+        const glm::vec3 windingNormal = n;
+
+        // two-sided: face the side the sphere starts on
+        float dist = glm::dot(n, start - tri.a);
+        if (dist < 0.0f) { n = -n; dist = -dist; }
+        float nDotV = glm::dot(n, delta);
+
+        float best = hit.t;
+        glm::vec3 contact;
+        bool found = false;
+
+        // face: only while approaching from outside the plane slab
+        if (dist >= r && nDotV < 0.0f) {
+            float t0 = (r - dist) / nDotV;
+            if (t0 > 1.0f) return false;
+            if (t0 < best) {
+                glm::vec3 p = start - n * r + delta * t0;
+                if (pointInTriangle(p, tri, windingNormal)) {
+                    hit.t = t0;
+                    hit.normal = n;
+                    hit.hit = true;
+                    return true;
+                }
+            }
+        }
+        else if (dist >= r) {
+            return false; // parallel or moving away, outside the slab
+        }
+        else {
+            // already touching (after a slide, or rounding): the distance to a convex
+            // triangle only shrinks along delta if it shrinks at the start, so block
+            // that and let any other motion pass
+            glm::vec3 away = start - closestPointOnTriangle(start, tri);
+            float len = glm::length(away);
+            if (len < r) {
+                glm::vec3 normal = len > 1e-6f ? away / len : n;
+                if (glm::dot(delta, normal) >= 0.0f)
+                    return false;
+                hit.t = 0.0f;
+                hit.normal = normal;
+                hit.hit = true;
+                return true;
+            }
+        }
+
+        // corners
+        float velSq = glm::dot(delta, delta);
+        const glm::vec3 corners[3] = { tri.a, tri.b, tri.c };
+        for (const glm::vec3& p : corners) {
+            glm::vec3 toStart = start - p;
+            float t;
+            if (lowestRoot(velSq, 2.0f * glm::dot(delta, toStart), glm::dot(toStart, toStart) - r * r, best, t)) {
+                best = t;
+                contact = p;
+                found = true;
+            }
+        }
+
+        // edges
+        for (int e = 0; e < 3; e++) {
+            const glm::vec3& p1 = corners[e];
+            const glm::vec3& p2 = corners[(e + 1) % 3];
+            glm::vec3 edge = p2 - p1;
+            glm::vec3 toEdge = p1 - start;
+
+            float edgeSq = glm::dot(edge, edge);
+            float edgeDotVel = glm::dot(edge, delta);
+            float edgeDotBase = glm::dot(edge, toEdge);
+
+            float a = edgeSq * -velSq + edgeDotVel * edgeDotVel;
+            float b = edgeSq * (2.0f * glm::dot(delta, toEdge)) - 2.0f * edgeDotVel * edgeDotBase;
+            float c = edgeSq * (r * r - glm::dot(toEdge, toEdge)) + edgeDotBase * edgeDotBase;
+
+            float t;
+            if (lowestRoot(a, b, c, best, t)) {
+                float f = (edgeDotVel * t - edgeDotBase) / edgeSq;
+                if (f >= 0.0f && f <= 1.0f) {
+                    best = t;
+                    contact = p1 + edge * f;
+                    found = true;
+                }
+            }
+        }
+
+        if (!found) return false;
+
+        glm::vec3 away = start + delta * best - contact;
+        float len = glm::length(away);
+        hit.t = best;
+        hit.normal = len > 1e-6f ? away / len : n;
+        hit.hit = true;
+        return true;
+    }
+
+    int ColliderGrid::cellX(float x) const {
+        return std::min(std::max((int)std::floor((x - origin.x) * invCellSize), 0), cellsX - 1);
+    }
+
+    int ColliderGrid::cellZ(float z) const {
+        return std::min(std::max((int)std::floor((z - origin.y) * invCellSize), 0), cellsZ - 1);
+    }
+
+    void ColliderGrid::build(const std::vector<AABB>& boxes, float requestedCellSize) {
+        colliders = boxes;
+        cellStart.clear();
+        cellItems.clear();
+        cellsX = cellsZ = 0;
+
+        if (colliders.empty())
+            return;
+
+        glm::vec2 lo(colliders[0].min.x, colliders[0].min.z);
+        glm::vec2 hi(colliders[0].max.x, colliders[0].max.z);
+        float footprint = 0.0f;
+        for (const auto& b : colliders) {
+            lo.x = std::min(lo.x, b.min.x); lo.y = std::min(lo.y, b.min.z);
+            hi.x = std::max(hi.x, b.max.x); hi.y = std::max(hi.y, b.max.z);
+            footprint += std::max(b.max.x - b.min.x, b.max.z - b.min.z);
+        }
+
+        // about one collider per cell on average, capped at 1024 x 1024 cells
+        cellSize = requestedCellSize > 0.0f ? requestedCellSize : std::max(footprint / colliders.size() * 2.0f, 0.25f);
+        float extent = std::max(hi.x - lo.x, hi.y - lo.y);
+        cellSize = std::max(cellSize, extent / 1024.0f);
+        invCellSize = 1.0f / cellSize;
+
+        origin = lo;
+        cellsX = std::max(1, (int)std::ceil((hi.x - lo.x) * invCellSize));
+        cellsZ = std::max(1, (int)std::ceil((hi.y - lo.y) * invCellSize));
+
+        // count, prefix sum, fill
+        std::vector<int> counts((size_t)cellsX * cellsZ + 1, 0);
+        for (const auto& b : colliders) {
+            for (int z = cellZ(b.min.z); z <= cellZ(b.max.z); z++)
+                for (int x = cellX(b.min.x); x <= cellX(b.max.x); x++)
+                    counts[(size_t)z * cellsX + x]++;
+        }
+
+        cellStart.assign(counts.size(), 0);
+        for (size_t c = 1; c < counts.size(); c++)
+            cellStart[c] = cellStart[c - 1] + counts[c - 1];
+
+        cellItems.resize(cellStart.back());
+        std::vector<int> cursor(cellStart.begin(), cellStart.end() - 1);
+        for (int i = 0; i < (int)colliders.size(); i++) {
+            const AABB& b = colliders[i];
+            for (int z = cellZ(b.min.z); z <= cellZ(b.max.z); z++)
+                for (int x = cellX(b.min.x); x <= cellX(b.max.x); x++)
+                    cellItems[cursor[(size_t)z * cellsX + x]++] = i;
+        }
+    }
+
+    void ColliderGrid::query(const AABB& region, std::vector<int>& out) const {
+        if (cellsX == 0)
+            return;
+
+        int x0 = cellX(region.min.x), x1 = cellX(region.max.x);
+        int z0 = cellZ(region.min.z), z1 = cellZ(region.max.z);
+
+        for (int z = z0; z <= z1; z++) {
+            for (int x = x0; x <= x1; x++) {
+                size_t cell = (size_t)z * cellsX + x;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    const AABB& b = colliders[cellItems[k]];
+
+                    if (b.min.x > region.max.x || b.max.x < region.min.x ||
+                        b.min.y > region.max.y || b.max.y < region.min.y ||
+                        b.min.z > region.max.z || b.max.z < region.min.z)
+                        continue;
+
+                    // a collider spanning several visited cells is reported only from
+                    // the cell holding the lower corner of the overlap, so no dedup set is needed
+                    if (cellX(std::max(b.min.x, region.min.x)) != x || cellZ(std::max(b.min.z, region.min.z)) != z)
+                        continue;
+
+                    out.push_back(cellItems[k]);
+                }
+            }
+        }
+    }
+
+    void ColliderGrid::querySphere(const glm::vec3& c, float r, std::vector<int>& out) const {
+        query(AABB{ c - glm::vec3(r), c + glm::vec3(r) }, out);
+    }
+
+    bool ColliderGrid::sweepSphere(const glm::vec3& start, const glm::vec3& delta, float r, SweepHit& hit) const {
+        if (cellsX == 0)
+            return false;
+
+        glm::vec3 end = start + delta;
+        thread_local std::vector<int> candidates;
+        candidates.clear();
+        query(AABB{ glm::min(start, end) - glm::vec3(r), glm::max(start, end) + glm::vec3(r) }, candidates);
+        if (candidates.empty())
+            return false;
+
+#if defined(GPS_COLLISION_SIMD)
+        // slab test against 4 grown boxes per instruction; the winner is redone in scalar for its normal
+        float inv[3];
+        for (int k = 0; k < 3; k++) {
+            float d = delta[k];
+            if (std::fabs(d) < 1e-12f) d = d < 0.0f ? -1e-12f : 1e-12f;
+            inv[k] = 1.0f / d;
+        }
+
+        const __m128 origin4[3] = { _mm_set1_ps(start.x), _mm_set1_ps(start.y), _mm_set1_ps(start.z) };
+        const __m128 inv4[3] = { _mm_set1_ps(inv[0]), _mm_set1_ps(inv[1]), _mm_set1_ps(inv[2]) };
+        const __m128 zero = _mm_setzero_ps();
+
+        float best = hit.t;
+        int bestIndex = -1;
+        bool found = false;
+
+        for (size_t i = 0; i < candidates.size(); i += 4) {
+            // gather 4 boxes as SoA; missing lanes get a box far outside the path
+            alignas(16) float lo[3][4], hi[3][4];
+            for (int j = 0; j < 4; j++) {
+                bool valid = i + j < candidates.size();
+                const AABB* b = valid ? &colliders[candidates[i + j]] : nullptr;
+                for (int k = 0; k < 3; k++) {
+                    lo[k][j] = valid ? b->min[k] - r : 1e30f;
+                    hi[k][j] = valid ? b->max[k] + r : 1e30f;
+                }
+            }
+
+            __m128 tEnter = _mm_set1_ps(-1e30f);
+            __m128 tExit = _mm_set1_ps(1e30f);
+            for (int k = 0; k < 3; k++) {
+                __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(lo[k]), origin4[k]), inv4[k]);
+                __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(hi[k]), origin4[k]), inv4[k]);
+                tEnter = _mm_max_ps(tEnter, _mm_min_ps(t0, t1));
+                tExit = _mm_min_ps(tExit, _mm_max_ps(t0, t1));
+            }
+
+            __m128 overlap = _mm_cmple_ps(tEnter, tExit);
+            __m128 hitMask = _mm_and_ps(overlap,
+                _mm_and_ps(_mm_cmpge_ps(tEnter, zero), _mm_cmplt_ps(tEnter, _mm_set1_ps(best))));
+            int mask = _mm_movemask_ps(hitMask);
+
+            // path starting inside a grown box (rare): the scalar test decides which face blocks
+            int inside = _mm_movemask_ps(_mm_and_ps(overlap, _mm_and_ps(_mm_cmplt_ps(tEnter, zero), _mm_cmpge_ps(tExit, zero))));
+            for (int j = 0; j < 4; j++) {
+                if ((inside & (1 << j)) && sweepSphereAABB(start, delta, r, colliders[candidates[i + j]], hit)) {
+                    best = hit.t;
+                    bestIndex = -1;
+                    found = true;
+                }
+            }
+            if (!mask) continue;
+
+            alignas(16) float enter[4];
+            _mm_store_ps(enter, tEnter);
+            for (int j = 0; j < 4; j++) {
+                if ((mask & (1 << j)) && enter[j] < best) {
+                    best = enter[j];
+                    bestIndex = candidates[i + j];
+                }
+            }
+        }
+
+        if (bestIndex >= 0)
+            found |= sweepSphereAABB(start, delta, r, colliders[bestIndex], hit);
+        return found;
+#else
+        bool found = false;
+        for (int i : candidates)
+            found |= sweepSphereAABB(start, delta, r, colliders[i], hit);
+        return found;
+#endif
+    }
+
+    glm::vec3 ColliderGrid::slideSphere(glm::vec3 start, glm::vec3 delta, float r, int maxIterations,
+        const TriangleBVH* mesh) const {
+        const float skin = 0.001f;
+
+        for (int i = 0; i < maxIterations; i++) {
+            float len = glm::length(delta);
+            if (len < 1e-6f)
+                return start;
+
+            SweepHit hit;
+            bool found = sweepSphere(start, delta, r, hit);
+            if (mesh && mesh->sweepSphere(start, delta, r, hit))
+                found = true;
+            if (!found)
+                return start + delta;
+
+            // stop just short of the contact, then slide what is left along the surface
+            float travel = std::max(hit.t * len - skin, 0.0f);
+            start += delta * (travel / len);
+            delta = delta * (1.0f - hit.t);
+            delta -= hit.normal * glm::dot(delta, hit.normal);
+        }
+
+        // out of iterations: drop the remaining motion rather than risk passing through
+        return start;
+    }
+
+    bool ColliderGrid::benchmark(int colliderCount, int queryCount) {
+        typedef std::chrono::steady_clock clock;
+
+        // colliders the size of lanterns / trunks / wall pieces over a 200 x 200 garden
+        uint32_t rng = 1234u;
+        auto random01 = [&rng]() {
+            rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+            return (rng & 0xFFFFFF) / float(0x1000000);
+        };
+
+        std::vector<AABB> boxes(colliderCount);
+        for (auto& b : boxes) {
+            glm::vec3 c(random01() * 200.0f, random01() * 2.0f, random01() * 200.0f);
+            glm::vec3 h(0.2f + random01() * 1.5f, 0.5f + random01() * 2.0f, 0.2f + random01() * 1.5f);
+            b = AABB{ c - h, c + h };
+        }
+
+        std::vector<glm::vec3> spheres(queryCount);
+        for (auto& p : spheres) p = glm::vec3(random01() * 200.0f, 1.5f, random01() * 200.0f);
+        const float radius = 0.35f;
+
+        auto start = clock::now();
+        ColliderGrid grid;
+        grid.build(boxes);
+        double buildMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        size_t bruteHits = 0;
+        start = clock::now();
+        for (const auto& p : spheres)
+            for (const auto& b : boxes)
+                if (sphereIntersectsAABB(p, radius, b)) bruteHits++;
+        double bruteUs = std::chrono::duration<double, std::micro>(clock::now() - start).count() / queryCount;
+
+        size_t gridHits = 0;
+        std::vector<int> candidates;
+        start = clock::now();
+        for (const auto& p : spheres) {
+            candidates.clear();
+            grid.querySphere(p, radius, candidates);
+            for (int i : candidates)
+                if (sphereIntersectsAABB(p, radius, boxes[i])) gridHits++;
+        }
+        double gridUs = std::chrono::duration<double, std::micro>(clock::now() - start).count() / queryCount;
+
+        std::cout << "Collision broadphase: " << colliderCount << " colliders, " << queryCount << " queries" << std::endl;
+        std::cout << "  grid build: " << buildMs << " ms (" << grid.cellsX << " x " << grid.cellsZ
+            << " cells of " << grid.cellSize << ")" << std::endl;
+        std::cout << "  brute force: " << bruteUs << " us/query, " << bruteHits << " hits" << std::endl;
+        std::cout << "  grid:        " << gridUs << " us/query, " << gridHits << " hits" << std::endl;
+
+        bool ok = gridHits == bruteHits;
+        if (!ok)
+            std::cout << "ERROR: grid and brute force disagree" << std::endl;
+
+        // tunnelling: walk at cameraSpeed 2.5 towards a 5 cm wall at x = 0 with huge frame times
+        ColliderGrid wall;
+        wall.build({ AABB{ glm::vec3(-0.025f, 0.0f, -50.0f), glm::vec3(0.025f, 4.0f, 50.0f) } });
+        const float frameTimes[] = { 1.0f / 60.0f, 0.25f, 1.0f, 4.0f };
+        const int paths = 1000;
+
+        std::cout << "  tunnelling through a 5 cm wall (" << paths << " paths, 4 s each):" << std::endl;
+        for (float dt : frameTimes) {
+            int discreteThrough = 0, sweptThrough = 0;
+            int steps = std::max(1, (int)(4.0f / dt));
+
+            for (int p = 0; p < paths; p++) {
+                float angle = (random01() - 0.5f) * 2.4f;
+                glm::vec3 step = glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * (2.5f * dt);
+                glm::vec3 startPos(-1.0f, 1.5f, random01() * 20.0f - 10.0f);
+
+                glm::vec3 discrete = startPos, swept = startPos;
+                for (int s = 0; s < steps; s++) {
+                    discrete += step;
+                    if (sphereIntersectsAABB(discrete, radius, wall.boxes()[0]))
+                        discrete = resolveSphereAABB(discrete, radius, wall.boxes()[0]);
+
+                    swept = wall.slideSphere(swept, step, radius);
+                }
+                discreteThrough += discrete.x > 0.0f;
+                sweptThrough += swept.x > 0.0f;
+            }
+
+            std::cout << "    dt " << dt << " s: discrete " << discreteThrough << ", swept " << sweptThrough << std::endl;
+            if (sweptThrough) {
+                std::cout << "ERROR: swept sphere passed through the wall at dt " << dt << std::endl;
+                ok = false;
+            }
+        }
+
+        // already touching or slightly inside the grown wall (after a slide), then a 10 m step into it
+        int contactThrough = 0;
+        for (int p = 0; p < paths; p++) {
+            float overlap = random01() * 0.01f;
+            float angle = (random01() - 0.5f) * 2.4f;
+            glm::vec3 startPos(-0.025f - radius + overlap, 1.5f, random01() * 20.0f - 10.0f);
+            glm::vec3 end = wall.slideSphere(startPos, glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * 10.0f, radius);
+            contactThrough += end.x > 0.0f;
+        }
+        std::cout << "  starting in contact: swept " << contactThrough << " of " << paths << " through" << std::endl;
+        if (contactThrough) {
+            std::cout << "ERROR: swept sphere starting in contact passed through the wall" << std::endl;
+            ok = false;
+        }
+
+        // the same paths against a zero-thickness wall of mesh triangles (the ground BVH path)
+        TriangleBVH wallMesh;
+        wallMesh.build({
+            Triangle{ glm::vec3(0.0f, 0.0f, -50.0f), glm::vec3(0.0f, 4.0f, -50.0f), glm::vec3(0.0f, 0.0f, 50.0f) },
+            Triangle{ glm::vec3(0.0f, 4.0f, -50.0f), glm::vec3(0.0f, 4.0f, 50.0f), glm::vec3(0.0f, 0.0f, 50.0f) }
+        });
+        ColliderGrid noBoxes;
+        noBoxes.build({});
+
+        std::cout << "  tunnelling through a triangle wall:" << std::endl;
+        for (float dt : frameTimes) {
+            int meshThrough = 0;
+            int steps = std::max(1, (int)(4.0f / dt));
+
+            for (int p = 0; p < paths; p++) {
+                float angle = (random01() - 0.5f) * 2.4f;
+                glm::vec3 step = glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * (2.5f * dt);
+                glm::vec3 swept(-1.0f, 1.5f, random01() * 20.0f - 10.0f);
+                for (int s = 0; s < steps; s++)
+                    swept = noBoxes.slideSphere(swept, step, radius, 4, &wallMesh);
+                meshThrough += swept.x > 0.0f;
+            }
+
+            std::cout << "    dt " << dt << " s: swept " << meshThrough << std::endl;
+            if (meshThrough) {
+                std::cout << "ERROR: swept sphere passed through the triangle wall at dt " << dt << std::endl;
+                ok = false;
+            }
+        }
+
+        int meshContactThrough = 0;
+        for (int p = 0; p < paths; p++) {
+            float overlap = random01() * 0.01f;
+            float angle = (random01() - 0.5f) * 2.4f;
+            glm::vec3 startPos(-radius + overlap, 1.5f, random01() * 20.0f - 10.0f);
+            glm::vec3 end = noBoxes.slideSphere(startPos, glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * 10.0f,
+                radius, 4, &wallMesh);
+            meshContactThrough += end.x > 0.0f;
+        }
+        std::cout << "  starting in contact: swept " << meshContactThrough << " of " << paths << " through" << std::endl;
+        if (meshContactThrough) {
+            std::cout << "ERROR: swept sphere starting in contact passed through the triangle wall" << std::endl;
+            ok = false;
+        }
+
+        return ok;
+    }
+}
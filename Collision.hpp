@@ -0,0 +1,89 @@
+#ifndef Collision_hpp
+#define Collision_hpp
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace gps {
+
+    // axis aligned box used by the camera and the petal simulation
+    struct AABB {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    struct Triangle {
+        glm::vec3 a, b, c;
+    };
+
+    // first contact of a moving sphere; t is the fraction of the motion travelled
+    struct SweepHit {
+        float t = 1.0f;
+        glm::vec3 normal = glm::vec3(0.0f);
+        bool hit = false;
+    };
+
+    // sphere vs AABB
+    bool sphereIntersectsAABB(const glm::vec3& c, float r, const AABB& b);
+    // pushes the sphere out of the box along the shortest direction
+    glm::vec3 resolveSphereAABB(glm::vec3 c, float r, const AABB& b);
+
+    // continuous tests for a sphere moving from start to start + delta; they only
+    // report hits earlier than hit.t, so several can be chained to find the nearest.
+    // The box test sweeps against the box grown by r (square edges, slightly conservative);
+    // a sphere already overlapping it at start is stopped at t = 0 when moving further in.
+    bool sweepSphereAABB(const glm::vec3& start, const glm::vec3& delta, float r, const AABB& b, SweepHit& hit);
+    // two-sided, against the face, its edges and its corners
+    bool sweepSphereTriangle(const glm::vec3& start, const glm::vec3& delta, float r, const Triangle& tri, SweepHit& hit);
+
+    class TriangleBVH;
+
+    // uniform grid over the XZ plane; each collider is listed in every cell it
+    // overlaps. Queries are read-only and can run from several threads.
+    class ColliderGrid {
+
+    public:
+        // cellSize <= 0 picks one from the average collider footprint
+        void build(const std::vector<AABB>& boxes, float cellSize = 0.0f);
+
+        // appends the index of every collider overlapping region, each once
+        void query(const AABB& region, std::vector<int>& out) const;
+        void querySphere(const glm::vec3& c, float r, std::vector<int>& out) const;
+
+        // nearest hit of a moving sphere among the colliders along its path
+        bool sweepSphere(const glm::vec3& start, const glm::vec3& delta, float r, SweepHit& hit) const;
+
+        // moves the sphere by delta, sliding along whatever it touches for up to
+        // maxIterations contacts (the colliders, and the triangles of mesh near the
+        // path when given); returns the final centre
+        glm::vec3 slideSphere(glm::vec3 start, glm::vec3 delta, float r, int maxIterations = 4,
+            const TriangleBVH* mesh = nullptr) const;
+
+        const std::vector<AABB>& boxes() const { return colliders; }
+        size_t size() const { return colliders.size(); }
+
+        // brute force vs grid broadphase for random colliders and player-sized spheres,
+        // then discrete vs swept response for very large steps through thin walls;
+        // false when the grid misses a hit or a swept sphere passes through
+        static bool benchmark(int colliderCount, int queryCount);
+
+    private:
+        std::vector<AABB> colliders;
+
+        glm::vec2 origin = glm::vec2(0.0f);
+        float cellSize = 1.0f;
+        float invCellSize = 1.0f;
+        int cellsX = 0;
+        int cellsZ = 0;
+
+        // CSR layout: collider indices of cell c are cellItems[cellStart[c] .. cellStart[c + 1])
+        std::vector<int> cellStart;
+        std::vector<int> cellItems;
+
+        int cellX(float x) const;
+        int cellZ(float z) const;
+    };
+}
+
+#endif /* Collision_hpp */
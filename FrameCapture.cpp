@@ -0,0 +1,172 @@
+#include "FrameCapture.hpp"
+#include "ImageWriter.hpp"
+#include "Profiler.hpp"
+#include "ResourceTracker.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace gps {
+
+    void FrameCapture::init(JobSystem* jobSystem) {
+        jobs = jobSystem;
+    }
+
+    void FrameCapture::release() {
+        stopSequence();
+        finish();
+        for (Slot& s : slots) {
+            ResourceTracker::remove(ResourceTracker::Kind::Buffer, s.pbo);
+            if (s.pbo) glDeleteBuffers(1, &s.pbo);
+            s = Slot();
+        }
+    }
+
+    void FrameCapture::screenshot(const std::string& fileName) {
+        screenshotFile = fileName;
+    }
+
+    void FrameCapture::startSequence(const std::string& prefix, Format format) {
+        sequencePrefix = prefix;
+        sequenceFormat = format;
+        sequenceFrame = 0;
+        std::cout << "Recording frames to " << prefix << "_*" << (format == Format::Png ? ".png" : ".raw") << std::endl;
+    }
+
+    void FrameCapture::stopSequence() {
+        if (sequencePrefix.empty())
+            return;
+        std::cout << "Recorded " << sequenceFrame << " frames to " << sequencePrefix << "_*" << std::endl;
+        sequencePrefix.clear();
+    }
+
+    void FrameCapture::capture(GLuint framebuffer, int width, int height) {
+        // hand finished readbacks to the writers, oldest first
+        for (int k = 0; k < RING; k++) {
+            Slot& s = slots[(next + k) % RING];
+            if (s.fence && !collect(s, false))
+                break;
+        }
+
+        if ((screenshotFile.empty() && sequencePrefix.empty()) || width <= 0 || height <= 0)
+            return;
+
+        PROFILE_ZONE("capture");
+        Slot& slot = slots[next];
+        if (slot.fence)
+            collect(slot, true); // the ring is full
+
+        if (!slot.pbo)
+            glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        GLsizeiptr size = (GLsizeiptr)width * height * 4;
+        if (slot.size != size) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+            slot.size = size;
+            ResourceTracker::add(ResourceTracker::Kind::Buffer, slot.pbo, "capture", "readback ring", size);
+        }
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        // into the bound buffer: returns without waiting for the frame to finish
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        slot.width = width;
+        slot.height = height;
+        if (!sequencePrefix.empty()) {
+            char number[16];
+            std::snprintf(number, sizeof(number), "_%06d", sequenceFrame++);
+            slot.format = sequenceFormat;
+            slot.fileName = sequencePrefix + number + (sequenceFormat == Format::Png ? ".png" : ".raw");
+        }
+        else {
+            slot.format = Format::Png;
+            slot.fileName = screenshotFile;
+        }
+        // a screenshot taken while recording is the recorded frame
+        screenshotFile.clear();
+
+        next = (next + 1) % RING;
+    }
+
+    bool FrameCapture::collect(Slot& slot, bool wait) {
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000ull : 0);
+        if (status == GL_TIMEOUT_EXPIRED && !wait)
+            return false;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED) {
+            std::cout << "ERROR: frame capture readback failed, " << slot.fileName << " skipped" << std::endl;
+            return true;
+        }
+
+        // copy out and unmap right away; the conversion happens on the writer
+        std::shared_ptr<std::vector<uint8_t>> rgba = std::make_shared<std::vector<uint8_t>>(slot.size);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+        if (mapped) {
+            std::memcpy(rgba->data(), mapped, slot.size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (!mapped) {
+            std::cout << "ERROR: could not map frame capture buffer, " << slot.fileName << " skipped" << std::endl;
+            return true;
+        }
+
+        int width = slot.width;
+        int height = slot.height;
+        std::string fileName = slot.fileName;
+        Format format = slot.format;
+        std::atomic<int>* queued = &queuedWrites;
+
+        auto write = [rgba, width, height, fileName, format, queued]() {
+            PROFILE_ZONE("write capture");
+            // GL rows start at the bottom; drop alpha, the petal pass leaves it partly transparent
+            std::vector<uint8_t> rgb((size_t)width * height * 3);
+            for (int y = 0; y < height; y++) {
+                const uint8_t* src = rgba->data() + (size_t)(height - 1 - y) * width * 4;
+                uint8_t* dst = rgb.data() + (size_t)y * width * 3;
+                for (int x = 0; x < width; x++, src += 4, dst += 3) {
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = src[2];
+                }
+            }
+
+            if (format == Format::Png)
+                ImageWriter::writePng(fileName, width, height, rgb.data());
+            else
+                ImageWriter::writeRaw(fileName, width, height, rgb.data());
+            queued->fetch_sub(1);
+        };
+
+        queuedWrites.fetch_add(1);
+        if (!jobs) {
+            write();
+            return true;
+        }
+
+        // the encoders fell behind (or there are no workers): help until they catch up
+        if (queuedWrites.load() > MAX_QUEUED_WRITES)
+            jobs->wait(writes);
+        jobs->run(write, &writes);
+        return true;
+    }
+
+    void FrameCapture::finish() {
+        for (int k = 0; k < RING; k++) {
+            Slot& s = slots[(next + k) % RING];
+            if (s.fence)
+                collect(s, true);
+        }
+        if (jobs)
+            jobs->wait(writes);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef FrameCapture_hpp
+#define FrameCapture_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include "JobSystem.hpp"
+
+#include <atomic>
+#include <string>
+
+namespace gps {
+
+    // screenshots and frame sequences without stalling the pipeline: each
+    // captured frame is read into one of RING pixel buffer objects, mapped once
+    // its fence has signalled (normally a frame or two later) and encoded and
+    // written by a job. Only a full ring makes capture() wait for the GPU.
+    class FrameCapture {
+
+    public:
+        enum class Format { Png, Raw };
+
+        // jobs encode and write the files; nullptr writes them on the calling thread
+        void init(JobSystem* jobs);
+        // finishes outstanding captures and deletes the buffers; needs the GL context
+        void release();
+
+        // the next captured frame goes to fileName (PNG)
+        void screenshot(const std::string& fileName);
+        // every frame goes to <prefix>_000000.png (or .raw) until stopSequence()
+        void startSequence(const std::string& prefix, Format format);
+        void stopSequence();
+        bool recording() const { return !sequencePrefix.empty(); }
+
+        // call once per frame after rendering, before the buffer swap;
+        // framebuffer 0 reads the back buffer
+        void capture(GLuint framebuffer, int width, int height);
+        // waits for every queued readback and file
+        void finish();
+
+    private:
+        static const int RING = 3;
+        // encodes waiting for a worker before capture() waits for them
+        static const int MAX_QUEUED_WRITES = 8;
+
+        struct Slot {
+            GLuint pbo = 0;
+            GLsizeiptr size = 0;
+            GLsync fence = nullptr;
+            int width = 0;
+            int height = 0;
+            std::string fileName;
+            Format format = Format::Png;
+        };
+
+        Slot slots[RING];
+        int next = 0;
+
+        JobSystem* jobs = nullptr;
+        JobCounter writes;
+        std::atomic<int> queuedWrites{ 0 };
+
+        std::string screenshotFile;
+        std::string sequencePrefix;
+        Format sequenceFormat = Format::Png;
+        int sequenceFrame = 0;
+
+        // maps a read-back slot and queues its file; false if wait is off and the GPU is not done
+        bool collect(Slot& slot, bool wait);
+    };
+}
+
+#endif /* FrameCapture_hpp */
@@ -0,0 +1,93 @@
+#include "GLStats.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace gps {
+
+    GLCounters GLStats::frame;
+    GLuint GLStats::currentProgram = 0;
+    GLenum GLStats::activeUnit = 0;
+    GLuint GLStats::unitTextures[32] = {};
+
+    GLCounters GLStats::window;
+    int GLStats::windowFrames = 0;
+    GLCounters GLStats::lastWindow;
+    int GLStats::lastWindowFrames = 0;
+    bool GLStats::consoleReport = false;
+
+    void GLCounters::add(const GLCounters& o) {
+        drawCalls += o.drawCalls;
+        elements += o.elements;
+        programBinds += o.programBinds;
+        redundantProgramBinds += o.redundantProgramBinds;
+        textureBinds += o.textureBinds;
+        redundantTextureBinds += o.redundantTextureBinds;
+        vertexArrayBinds += o.vertexArrayBinds;
+        framebufferBinds += o.framebufferBinds;
+        uniformUploads += o.uniformUploads;
+        uniformLookups += o.uniformLookups;
+        bufferUploads += o.bufferUploads;
+        bufferBytes += o.bufferBytes;
+        textureUploads += o.textureUploads;
+        stateChanges += o.stateChanges;
+    }
+
+    void GLStats::beginFrame() {
+        frame = GLCounters();
+        // code outside the hooked files may have changed bindings; forget them
+        currentProgram = (GLuint)-1;
+        std::memset(unitTextures, 0xff, sizeof(unitTextures));
+    }
+
+    void GLStats::endFrame() {
+        window.add(frame);
+        if (++windowFrames < WINDOW)
+            return;
+
+        lastWindow = window;
+        lastWindowFrames = windowFrames;
+        window = GLCounters();
+        windowFrames = 0;
+
+        if (consoleReport)
+            std::cout << report() << std::endl;
+    }
+
+    GLCounters GLStats::average() {
+        GLCounters a;
+        int n = lastWindowFrames;
+        if (n == 0) return a;
+
+        a.drawCalls = lastWindow.drawCalls / n;
+        a.elements = lastWindow.elements / n;
+        a.programBinds = lastWindow.programBinds / n;
+        a.redundantProgramBinds = lastWindow.redundantProgramBinds / n;
+        a.textureBinds = lastWindow.textureBinds / n;
+        a.redundantTextureBinds = lastWindow.redundantTextureBinds / n;
+        a.vertexArrayBinds = lastWindow.vertexArrayBinds / n;
+        a.framebufferBinds = lastWindow.framebufferBinds / n;
+        a.uniformUploads = lastWindow.uniformUploads / n;
+        a.uniformLookups = lastWindow.uniformLookups / n;
+        a.bufferUploads = lastWindow.bufferUploads / n;
+        a.bufferBytes = lastWindow.bufferBytes / n;
+        a.textureUploads = lastWindow.textureUploads / n;
+        a.stateChanges = lastWindow.stateChanges / n;
+        return a;
+    }
+
+    std::string GLStats::report() {
+        GLCounters a = average();
+        std::ostringstream out;
+        out << "GL per frame (avg of " << lastWindowFrames << "): "
+            << a.drawCalls << " draws (" << a.elements << " elements), "
+            << a.programBinds << " programs (" << a.redundantProgramBinds << " redundant), "
+            << a.textureBinds << " texture binds (" << a.redundantTextureBinds << " redundant), "
+            << a.vertexArrayBinds << " VAO binds, " << a.framebufferBinds << " FBO binds, "
+            << a.uniformUploads << " uniforms, " << a.uniformLookups << " uniform lookups, "
+            << a.bufferUploads << " buffer uploads (" << a.bufferBytes / 1024 << " KB), "
+            << a.textureUploads << " texture uploads, " << a.stateChanges << " state changes";
+        return out.str();
+    }
+}
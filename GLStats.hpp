@@ -0,0 +1,71 @@
+#ifndef GLStats_hpp
+#define GLStats_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include <string>
+
+namespace gps {
+
+    struct GLCounters {
+        int drawCalls = 0;
+        long long elements = 0;       // vertices / indices submitted
+        int programBinds = 0;
+        int redundantProgramBinds = 0; // program already current
+        int textureBinds = 0;
+        int redundantTextureBinds = 0; // texture already bound on that unit
+        int vertexArrayBinds = 0;
+        int framebufferBinds = 0;
+        int uniformUploads = 0;
+        int uniformLookups = 0;        // glGetUniformLocation
+        int bufferUploads = 0;
+        long long bufferBytes = 0;
+        int textureUploads = 0;
+        int stateChanges = 0;          // enable/disable, blend, depth, viewport, polygon mode, culling
+
+        void add(const GLCounters& o);
+    };
+
+    // per-frame counts of the GL calls made by the files that include
+    // GLStatsHooks.hpp (the render code), with a rolling average report
+    class GLStats {
+
+    public:
+        // the calls since the last beginFrame()
+        static GLCounters frame;
+
+        static void beginFrame();
+        // adds the finished frame to the rolling window
+        static void endFrame();
+
+        // per-frame average over the last full window of WINDOW frames
+        static GLCounters average();
+        static std::string report();
+
+        // prints report() each time a window completes
+        static void setConsoleReport(bool enabled) { consoleReport = enabled; }
+        static bool consoleReportEnabled() { return consoleReport; }
+
+        // bound state as the hooks last saw it
+        static GLuint currentProgram;
+        static GLenum activeUnit;
+        static GLuint unitTextures[32];
+
+    private:
+        static const int WINDOW = 60;
+
+        static GLCounters window;
+        static int windowFrames;
+        static GLCounters lastWindow;
+        static int lastWindowFrames;
+        static bool consoleReport;
+    };
+}
+
+#endif /* GLStats_hpp */
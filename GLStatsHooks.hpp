@@ -0,0 +1,181 @@
+#ifndef GLStatsHooks_hpp
+#define GLStatsHooks_hpp
+
+// Counts the GL calls of the including file into gps::GLStats::frame by
+// redirecting them to the wrappers below. Include it after every other header
+// of a .cpp file; build with -DGPS_NO_GL_STATS to call GL directly.
+
+#include "GLStats.hpp"
+
+#if !defined(GPS_NO_GL_STATS)
+
+namespace gps {
+    namespace glhooks {
+
+        // the wrappers are defined before the macros below, so they call the real entry points
+
+        inline void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+            GLStats::frame.drawCalls++;
+            GLStats::frame.elements += count;
+            glDrawElements(mode, count, type, indices);
+        }
+
+        inline void drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint base) {
+            GLStats::frame.drawCalls++;
+            GLStats::frame.elements += count;
+            glDrawElementsBaseVertex(mode, count, type, indices, base);
+        }
+
+        inline void drawArrays(GLenum mode, GLint first, GLsizei count) {
+            GLStats::frame.drawCalls++;
+            GLStats::frame.elements += count;
+            glDrawArrays(mode, first, count);
+        }
+
+        inline void useProgram(GLuint program) {
+            GLStats::frame.programBinds++;
+            if (GLStats::currentProgram == program) GLStats::frame.redundantProgramBinds++;
+            GLStats::currentProgram = program;
+            glUseProgram(program);
+        }
+
+        inline void activeTexture(GLenum unit) {
+            GLStats::activeUnit = unit - GL_TEXTURE0;
+            glActiveTexture(unit);
+        }
+
+        inline void bindTexture(GLenum target, GLuint texture) {
+            GLStats::frame.textureBinds++;
+            GLuint unit = GLStats::activeUnit;
+            if (unit < 32) {
+                if (GLStats::unitTextures[unit] == texture) GLStats::frame.redundantTextureBinds++;
+                GLStats::unitTextures[unit] = texture;
+            }
+            glBindTexture(target, texture);
+        }
+
+        inline void bindVertexArray(GLuint vao) {
+            GLStats::frame.vertexArrayBinds++;
+            glBindVertexArray(vao);
+        }
+
+        inline void bindFramebuffer(GLenum target, GLuint fbo) {
+            GLStats::frame.framebufferBinds++;
+            glBindFramebuffer(target, fbo);
+        }
+
+        inline GLint getUniformLocation(GLuint program, const GLchar* name) {
+            GLStats::frame.uniformLookups++;
+            return glGetUniformLocation(program, name);
+        }
+
+        inline void uniform1i(GLint l, GLint v) { GLStats::frame.uniformUploads++; glUniform1i(l, v); }
+        inline void uniform1f(GLint l, GLfloat v) { GLStats::frame.uniformUploads++; glUniform1f(l, v); }
+        inline void uniform2f(GLint l, GLfloat x, GLfloat y) { GLStats::frame.uniformUploads++; glUniform2f(l, x, y); }
+        inline void uniform3f(GLint l, GLfloat x, GLfloat y, GLfloat z) { GLStats::frame.uniformUploads++; glUniform3f(l, x, y, z); }
+        inline void uniform3fv(GLint l, GLsizei n, const GLfloat* v) { GLStats::frame.uniformUploads++; glUniform3fv(l, n, v); }
+        inline void uniformMatrix3fv(GLint l, GLsizei n, GLboolean t, const GLfloat* v) { GLStats::frame.uniformUploads++; glUniformMatrix3fv(l, n, t, v); }
+        inline void uniformMatrix4fv(GLint l, GLsizei n, GLboolean t, const GLfloat* v) { GLStats::frame.uniformUploads++; glUniformMatrix4fv(l, n, t, v); }
+
+        inline void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+            GLStats::frame.bufferUploads++;
+            GLStats::frame.bufferBytes += size;
+            glBufferData(target, size, data, usage);
+        }
+
+        inline void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+            GLStats::frame.bufferUploads++;
+            GLStats::frame.bufferBytes += size;
+            glBufferSubData(target, offset, size, data);
+        }
+
+        inline void texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei w, GLsizei h,
+            GLint border, GLenum format, GLenum type, const void* pixels) {
+            GLStats::frame.textureUploads++;
+            glTexImage2D(target, level, internalFormat, w, h, border, format, type, pixels);
+        }
+
+        inline void compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei w, GLsizei h,
+            GLint border, GLsizei size, const void* data) {
+            GLStats::frame.textureUploads++;
+            glCompressedTexImage2D(target, level, internalFormat, w, h, border, size, data);
+        }
+
+        inline void enable(GLenum cap) { GLStats::frame.stateChanges++; glEnable(cap); }
+        inline void disable(GLenum cap) { GLStats::frame.stateChanges++; glDisable(cap); }
+        inline void blendFunc(GLenum s, GLenum d) { GLStats::frame.stateChanges++; glBlendFunc(s, d); }
+        inline void blendFunci(GLuint b, GLenum s, GLenum d) { GLStats::frame.stateChanges++; glBlendFunci(b, s, d); }
+        inline void depthMask(GLboolean f) { GLStats::frame.stateChanges++; glDepthMask(f); }
+        inline void depthFunc(GLenum f) { GLStats::frame.stateChanges++; glDepthFunc(f); }
+        inline void viewport(GLint x, GLint y, GLsizei w, GLsizei h) { GLStats::frame.stateChanges++; glViewport(x, y, w, h); }
+        inline void polygonMode(GLenum face, GLenum mode) { GLStats::frame.stateChanges++; glPolygonMode(face, mode); }
+        inline void cullFace(GLenum mode) { GLStats::frame.stateChanges++; glCullFace(mode); }
+        inline void frontFace(GLenum mode) { GLStats::frame.stateChanges++; glFrontFace(mode); }
+    }
+}
+
+#undef glDrawElements
+#undef glDrawElementsBaseVertex
+#undef glDrawArrays
+#undef glUseProgram
+#undef glActiveTexture
+#undef glBindTexture
+#undef glBindVertexArray
+#undef glBindFramebuffer
+#undef glGetUniformLocation
+#undef glUniform1i
+#undef glUniform1f
+#undef glUniform2f
+#undef glUniform3f
+#undef glUniform3fv
+#undef glUniformMatrix3fv
+#undef glUniformMatrix4fv
+#undef glBufferData
+#undef glBufferSubData
+#undef glTexImage2D
+#undef glCompressedTexImage2D
+#undef glEnable
+#undef glDisable
+#undef glBlendFunc
+#undef glBlendFunci
+#undef glDepthMask
+#undef glDepthFunc
+#undef glViewport
+#undef glPolygonMode
+#undef glCullFace
+#undef glFrontFace
+
+#define glDrawElements gps::glhooks::drawElements
+#define glDrawElementsBaseVertex gps::glhooks::drawElementsBaseVertex
+#define glDrawArrays gps::glhooks::drawArrays
+#define glUseProgram gps::glhooks::useProgram
+#define glActiveTexture gps::glhooks::activeTexture
+#define glBindTexture gps::glhooks::bindTexture
+#define glBindVertexArray gps::glhooks::bindVertexArray
+#define glBindFramebuffer gps::glhooks::bindFramebuffer
+#define glGetUniformLocation gps::glhooks::getUniformLocation
+#define glUniform1i gps::glhooks::uniform1i
+#define glUniform1f gps::glhooks::uniform1f
+#define glUniform2f gps::glhooks::uniform2f
+#define glUniform3f gps::glhooks::uniform3f
+#define glUniform3fv gps::glhooks::uniform3fv
+#define glUniformMatrix3fv gps::glhooks::uniformMatrix3fv
+#define glUniformMatrix4fv gps::glhooks::uniformMatrix4fv
+#define glBufferData gps::glhooks::bufferData
+#define glBufferSubData gps::glhooks::bufferSubData
+#define glTexImage2D gps::glhooks::texImage2D
+#define glCompressedTexImage2D gps::glhooks::compressedTexImage2D
+#define glEnable gps::glhooks::enable
+#define glDisable gps::glhooks::disable
+#define glBlendFunc gps::glhooks::blendFunc
+#define glBlendFunci gps::glhooks::blendFunci
+#define glDepthMask gps::glhooks::depthMask
+#define glDepthFunc gps::glhooks::depthFunc
+#define glViewport gps::glhooks::viewport
+#define glPolygonMode gps::glhooks::polygonMode
+#define glCullFace gps::glhooks::cullFace
+#define glFrontFace gps::glhooks::frontFace
+
+#endif
+
+#endif /* GLStatsHooks_hpp */
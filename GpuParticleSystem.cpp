@@ -0,0 +1,142 @@
+#include "GpuParticleSystem.hpp"
+#include "ResourceTracker.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+
+#include "GLStatsHooks.hpp"
+
+namespace gps {
+
+    GpuParticleSystem::~GpuParticleSystem() {
+        for (GLuint b : vbo)
+            ResourceTracker::remove(ResourceTracker::Kind::Buffer, b);
+        if (vbo[0]) glDeleteBuffers(2, vbo);
+        if (updateVAO[0]) glDeleteVertexArrays(2, updateVAO);
+        if (renderVAO[0]) glDeleteVertexArrays(2, renderVAO);
+    }
+
+    void GpuParticleSystem::init(int maxParticles, gps::Shader* updateShader, unsigned int seed) {
+        this->particleCount = maxParticles;
+        this->updateShader = updateShader;
+
+        // every petal starts unborn with a random delay, so births are spread
+        // over one lifetime instead of all petals spawning on the first step
+        std::vector<GpuParticle> initial(particleCount);
+        uint32_t rng = seed ? seed : 1u;
+        for (auto& p : initial) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            p.posLife = glm::vec4(0.0f, 0.0f, 0.0f, -(rng & 0xFFFFFF) / float(0x1000000));
+            p.velocity = glm::vec3(0.0f);
+        }
+
+        glGenBuffers(2, vbo);
+        glGenVertexArrays(2, updateVAO);
+        glGenVertexArrays(2, renderVAO);
+
+        for (int i = 0; i < 2; i++) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo[i]);
+            glBufferData(GL_ARRAY_BUFFER, initial.size() * sizeof(GpuParticle), initial.data(), GL_DYNAMIC_COPY);
+            ResourceTracker::add(ResourceTracker::Kind::Buffer, vbo[i], "petals", "GPU simulation",
+                (long long)(initial.size() * sizeof(GpuParticle)));
+
+            // simulation input: full state
+            glBindVertexArray(updateVAO[i]);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, posLife));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, velocity));
+
+            // rendering input: position + life, same layout as the CPU petal stream
+            glBindVertexArray(renderVAO[i]);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, posLife));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)(offsetof(GpuParticle, posLife) + 3 * sizeof(float)));
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        GLuint program = updateShader ? updateShader->shaderProgram : 0;
+        if (program) {
+            timeLoc = glGetUniformLocation(program, "uTime");
+            deltaTimeLoc = glGetUniformLocation(program, "uDeltaTime");
+            groundYLoc = glGetUniformLocation(program, "uGroundY");
+            treePosLoc = glGetUniformLocation(program, "treePos");
+            treeCountLoc = glGetUniformLocation(program, "treeCount");
+            colliderCountLoc = glGetUniformLocation(program, "colliderCount");
+            for (int i = 0; i < MAX_COLLIDERS; i++) {
+                std::string index = "[" + std::to_string(i) + "]";
+                colliderMinLoc[i] = glGetUniformLocation(program, ("colliderMin" + index).c_str());
+                colliderMaxLoc[i] = glGetUniformLocation(program, ("colliderMax" + index).c_str());
+            }
+        }
+
+        std::cout << "GPU sakura particles: " << particleCount << " (transform feedback)" << std::endl;
+    }
+
+    void GpuParticleSystem::addEmitter(glm::vec3 treePosition) {
+        emitters.push_back(treePosition);
+    }
+
+    void GpuParticleSystem::setColliders(const std::vector<gps::AABB>& boxes) {
+        colliders = boxes;
+        if (colliders.size() > MAX_COLLIDERS) {
+            std::cout << "GPU petals: only the first " << MAX_COLLIDERS << " colliders are used" << std::endl;
+            colliders.resize(MAX_COLLIDERS);
+        }
+    }
+
+    void GpuParticleSystem::setGroundHeight(float y) {
+        groundY = y;
+    }
+
+    void GpuParticleSystem::update(float time, float dt) {
+        if (!updateShader || updateShader->shaderProgram == 0 || emitters.empty())
+            return;
+
+        updateShader->useShaderProgram();
+
+        if (timeLoc != -1) glUniform1f(timeLoc, time);
+        if (deltaTimeLoc != -1) glUniform1f(deltaTimeLoc, dt);
+        if (groundYLoc != -1) glUniform1f(groundYLoc, groundY);
+
+        int treeCount = (int)std::min(emitters.size(), (size_t)3);
+        if (treePosLoc != -1) glUniform3fv(treePosLoc, treeCount, glm::value_ptr(emitters[0]));
+        if (treeCountLoc != -1) glUniform1i(treeCountLoc, treeCount);
+
+        if (colliderCountLoc != -1) glUniform1i(colliderCountLoc, (GLint)colliders.size());
+        for (size_t i = 0; i < colliders.size(); i++) {
+            if (colliderMinLoc[i] != -1) glUniform3fv(colliderMinLoc[i], 1, glm::value_ptr(colliders[i].min));
+            if (colliderMaxLoc[i] != -1) glUniform3fv(colliderMaxLoc[i], 1, glm::value_ptr(colliders[i].max));
+        }
+
+        // read [current], capture into [current ^ 1]; nothing is rasterized
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(updateVAO[current]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, vbo[current ^ 1]);
+
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, particleCount);
+        glEndTransformFeedback();
+
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glBindVertexArray(0);
+        glDisable(GL_RASTERIZER_DISCARD);
+
+        current ^= 1;
+    }
+
+    void GpuParticleSystem::draw() {
+        glBindVertexArray(renderVAO[current]);
+        glDrawArrays(GL_POINTS, 0, particleCount);
+        glBindVertexArray(0);
+    }
+}
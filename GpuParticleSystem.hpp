@@ -0,0 +1,77 @@
+#ifndef GpuParticleSystem_hpp
+#define GpuParticleSystem_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "Collision.hpp"
+#include "Shader.hpp"
+
+#include <vector>
+
+namespace gps {
+
+    // per-petal state kept on the GPU (petal_update.vert)
+    struct GpuParticle {
+        glm::vec4 posLife;  // xyz position, w life (< 0 while waiting to be born)
+        glm::vec3 velocity;
+    };
+
+    // stateful GPU petal simulation: position/velocity live in two buffers and are
+    // advanced with transform feedback (GL 4.1, no compute), ping-ponging every step
+    class GpuParticleSystem {
+
+    public:
+        ~GpuParticleSystem();
+
+        // updateShader must be built with submitFeedbackShader(..., { "tfPosLife", "tfVelocity" })
+        void init(int maxParticles, gps::Shader* updateShader, unsigned int seed = 1234u);
+        void addEmitter(glm::vec3 treePosition);
+        void setColliders(const std::vector<gps::AABB>& boxes);
+        void setGroundHeight(float y);
+
+        // runs one simulation step on the GPU, nothing is read back
+        void update(float time, float dt);
+        // draws the latest state with the currently bound point shader (petal.vert layout)
+        void draw();
+
+        int count() const { return particleCount; }
+        // buffer holding the latest state, laid out as GpuParticle
+        GLuint currentBuffer() const { return vbo[current]; }
+
+        static const int MAX_COLLIDERS = 8;
+
+    private:
+        int particleCount = 0;
+        gps::Shader* updateShader = nullptr;
+
+        // ping-pong pair: [current] is read, [current ^ 1] is written
+        GLuint vbo[2] = {};
+        GLuint updateVAO[2] = {};
+        GLuint renderVAO[2] = {};
+        int current = 0;
+
+        // uniform locations of updateShader, looked up once in init
+        GLint timeLoc = -1;
+        GLint deltaTimeLoc = -1;
+        GLint groundYLoc = -1;
+        GLint treePosLoc = -1;
+        GLint treeCountLoc = -1;
+        GLint colliderCountLoc = -1;
+        GLint colliderMinLoc[MAX_COLLIDERS] = {};
+        GLint colliderMaxLoc[MAX_COLLIDERS] = {};
+
+        std::vector<glm::vec3> emitters;
+        std::vector<gps::AABB> colliders;
+        float groundY = 0.0f;
+    };
+}
+
+#endif /* GpuParticleSystem_hpp */
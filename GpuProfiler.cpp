@@ -0,0 +1,147 @@
+#include "GpuProfiler.hpp"
+
+#include <cstring>
+#include <iostream>
+
+namespace gps {
+
+    void GpuProfiler::init() {
+        if (initialized)
+            return;
+        for (Slot& slot : slots)
+            glGenQueries(MAX_PASSES * 2, &slot.queries[0][0]);
+        initialized = true;
+    }
+
+    void GpuProfiler::release() {
+        if (!initialized)
+            return;
+        for (Slot& slot : slots) {
+            glDeleteQueries(MAX_PASSES * 2, &slot.queries[0][0]);
+            slot = Slot();
+        }
+        initialized = false;
+    }
+
+    void GpuProfiler::beginFrame() {
+        if (!initialized)
+            return;
+
+        Slot& slot = current();
+        if (slot.frame >= 0)
+            resolve(slot);
+
+        slot.frame = frameIndex;
+        slot.count = 0;
+        depth = 0;
+        droppedDepth = 0;
+    }
+
+    void GpuProfiler::endFrame() {
+        if (!initialized)
+            return;
+
+        // close passes left open by an early return
+        droppedDepth = 0;
+        while (depth > 0)
+            endPass();
+        frameIndex++;
+    }
+
+    void GpuProfiler::finish() {
+        if (!initialized)
+            return;
+
+        glFinish();
+        // oldest first
+        for (int k = 0; k < FRAMES_IN_FLIGHT; k++) {
+            Slot& slot = slots[(frameIndex + k) % FRAMES_IN_FLIGHT];
+            if (slot.frame >= 0)
+                resolve(slot);
+        }
+    }
+
+    void GpuProfiler::beginPass(const char* name) {
+        if (!initialized)
+            return;
+
+        // out of queries: this pass and everything nested in it go untimed,
+        // and their endPass calls must not close a recorded pass
+        Slot& slot = current();
+        if (droppedDepth > 0 || slot.count == MAX_PASSES || depth == MAX_PASSES) {
+            droppedDepth++;
+            return;
+        }
+
+        int index = slot.count++;
+        slot.names[index] = name;
+        glQueryCounter(slot.queries[index][0], GL_TIMESTAMP);
+        stack[depth++] = index;
+    }
+
+    void GpuProfiler::endPass() {
+        if (!initialized)
+            return;
+        if (droppedDepth > 0) {
+            droppedDepth--;
+            return;
+        }
+        if (depth == 0)
+            return;
+        glQueryCounter(current().queries[stack[--depth]][1], GL_TIMESTAMP);
+    }
+
+    void GpuProfiler::resolve(Slot& slot) {
+        // drop the frame rather than stall when a result is not back yet
+        GLuint available = 1;
+        for (int i = slot.count - 1; available && i >= 0; i--)
+            glGetQueryObjectuiv(slot.queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            droppedFrames++;
+            slot.frame = -1;
+            return;
+        }
+
+        latestPasses.clear();
+        for (int i = 0; i < slot.count; i++) {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(slot.queries[i][0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(slot.queries[i][1], GL_QUERY_RESULT, &end);
+            latestPasses.push_back(PassTime{ slot.names[i], end > begin ? (double)(end - begin) / 1.0e6 : 0.0 });
+        }
+        latestFrameIndex = slot.frame;
+        slot.frame = -1;
+
+        if (listener)
+            listener(latestFrameIndex, latestPasses);
+
+        if (logInterval > 0) {
+            for (const PassTime& p : latestPasses) {
+                bool found = false;
+                for (PassTime& sum : logSums) {
+                    if (std::strcmp(sum.name, p.name) == 0) {
+                        sum.ms += p.ms;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) logSums.push_back(p);
+            }
+            if (++logFrames >= logInterval)
+                log();
+        }
+    }
+
+    void GpuProfiler::log() {
+        std::cout << "GPU passes (avg of " << logFrames << " frames):";
+        for (const PassTime& sum : logSums)
+            std::cout << " " << sum.name << " " << sum.ms / logFrames << " ms";
+        if (droppedFrames > 0)
+            std::cout << " [" << droppedFrames << " frames not ready]";
+        std::cout << std::endl;
+
+        logSums.clear();
+        logFrames = 0;
+        droppedFrames = 0;
+    }
+}
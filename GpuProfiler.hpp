@@ -0,0 +1,86 @@
+#ifndef GpuProfiler_hpp
+#define GpuProfiler_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include <functional>
+#include <vector>
+
+namespace gps {
+
+    // GPU time per render pass from GL_TIMESTAMP query pairs. Each frame in
+    // flight has its own set of queries; a frame's results are read back when
+    // its slot comes round again, FRAMES_IN_FLIGHT frames later, so reading
+    // them never waits for the GPU. Passes may nest. Does nothing until init().
+    class GpuProfiler {
+
+    public:
+        struct PassTime {
+            const char* name;
+            double ms;
+        };
+
+        void init();
+        // deletes the queries; needs the GL context
+        void release();
+        bool enabled() const { return initialized; }
+
+        void beginFrame();
+        void endFrame();
+        // waits for and resolves every frame still in flight (shutdown, end of a benchmark)
+        void finish();
+
+        // name must outlive the profiler (a string literal)
+        void beginPass(const char* name);
+        void endPass();
+
+        // the newest frame whose results came back, and its number (-1 = none yet)
+        const std::vector<PassTime>& latest() const { return latestPasses; }
+        long long latestFrame() const { return latestFrameIndex; }
+
+        // print per-pass averages every `frames` resolved frames (0 = never)
+        void setLogInterval(int frames) { logInterval = frames; }
+        // called with every frame's results as they come back
+        void setListener(std::function<void(long long, const std::vector<PassTime>&)> callback) { listener = callback; }
+
+    private:
+        static const int FRAMES_IN_FLIGHT = 4;
+        static const int MAX_PASSES = 16;
+
+        struct Slot {
+            long long frame = -1;
+            int count = 0;
+            const char* names[MAX_PASSES] = {};
+            GLuint queries[MAX_PASSES][2] = {};
+        };
+
+        Slot slots[FRAMES_IN_FLIGHT];
+        bool initialized = false;
+        long long frameIndex = 0;
+        int stack[MAX_PASSES] = {};
+        int depth = 0;
+        // open passes that did not fit; the innermost ones, so they close first
+        int droppedDepth = 0;
+
+        std::vector<PassTime> latestPasses;
+        long long latestFrameIndex = -1;
+
+        int logInterval = 0;
+        int logFrames = 0;
+        int droppedFrames = 0;
+        std::vector<PassTime> logSums;
+        std::function<void(long long, const std::vector<PassTime>&)> listener;
+
+        Slot& current() { return slots[frameIndex % FRAMES_IN_FLIGHT]; }
+        void resolve(Slot& slot);
+        void log();
+    };
+}
+
+#endif /* GpuProfiler_hpp */
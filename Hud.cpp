@@ -0,0 +1,324 @@
+#include "Hud.hpp"
+#include "ResourceTracker.hpp"
+#include "GLStatsHooks.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#ifndef GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+
+namespace gps {
+
+    // 5x7 glyphs for ' ' to '_', one byte per row, bit 4 = leftmost pixel;
+    // lower case is drawn as upper case, anything else as '?'
+    static const int FIRST_GLYPH = 32;
+    static const int GLYPH_COUNT = 64;
+    static const uint8_t glyphs[GLYPH_COUNT][7] = {
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+        { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // '!'
+        { 0x0a, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00 }, // '"'
+        { 0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a }, // '#'
+        { 0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04 }, // '$'
+        { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // '%'
+        { 0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d }, // '&'
+        { 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 }, // '''
+        { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // '('
+        { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // ')'
+        { 0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00 }, // '*'
+        { 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 }, // '+'
+        { 0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08 }, // ','
+        { 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 }, // '-'
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c }, // '.'
+        { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // '/'
+        { 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e }, // '0'
+        { 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e }, // '1'
+        { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f }, // '2'
+        { 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e }, // '3'
+        { 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 }, // '4'
+        { 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e }, // '5'
+        { 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e }, // '6'
+        { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // '7'
+        { 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e }, // '8'
+        { 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c }, // '9'
+        { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 }, // ':'
+        { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08 }, // ';'
+        { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // '<'
+        { 0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00 }, // '='
+        { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // '>'
+        { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // '?'
+        { 0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e }, // '@'
+        { 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 }, // 'A'
+        { 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e }, // 'B'
+        { 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e }, // 'C'
+        { 0x1e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1e }, // 'D'
+        { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f }, // 'E'
+        { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 }, // 'F'
+        { 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f }, // 'G'
+        { 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 }, // 'H'
+        { 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e }, // 'I'
+        { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c }, // 'J'
+        { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // 'K'
+        { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f }, // 'L'
+        { 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 }, // 'M'
+        { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // 'N'
+        { 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e }, // 'O'
+        { 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 }, // 'P'
+        { 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d }, // 'Q'
+        { 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 }, // 'R'
+        { 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e }, // 'S'
+        { 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // 'T'
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e }, // 'U'
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 }, // 'V'
+        { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a }, // 'W'
+        { 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 }, // 'X'
+        { 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x04 }, // 'Y'
+        { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f }, // 'Z'
+        { 0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e }, // '['
+        { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, // backslash
+        { 0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e }, // ']'
+        { 0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00 }, // '^'
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f }, // '_'
+    };
+
+    static const int CELL_W = 6;
+    static const int CELL_H = 8;
+    static const int ATLAS_COLUMNS = 16;
+    static const int ATLAS_W = CELL_W * ATLAS_COLUMNS;
+    // four rows of glyphs, then a solid block for untextured quads
+    static const int ATLAS_H = CELL_H * (GLYPH_COUNT / ATLAS_COLUMNS + 1);
+
+    // vertex colours are packed as bytes R, G, B, A in memory (little endian)
+    static uint32_t rgba(int r, int g, int b, int a) {
+        return (uint32_t)r | (uint32_t)g << 8 | (uint32_t)b << 16 | (uint32_t)a << 24;
+    }
+
+    static const uint32_t TEXT = rgba(235, 235, 235, 255);
+    static const uint32_t LABEL = rgba(150, 200, 255, 255);
+    static const uint32_t PANEL = rgba(0, 0, 0, 170);
+    static const uint32_t GOOD = rgba(90, 220, 90, 255);
+    static const uint32_t SLOW = rgba(240, 200, 60, 255);
+    static const uint32_t BAD = rgba(240, 70, 60, 255);
+    static const uint32_t GUIDE = rgba(255, 255, 255, 90);
+
+    static bool hasExtension(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* e = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (e && std::strcmp(e, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    void Hud::init() {
+        shader.loadShader("shaders/hud.vert", "shaders/hud.frag");
+        shader.useShaderProgram();
+        screenSizeLoc = glGetUniformLocation(shader.shaderProgram, "screenSize");
+        glUniform1i(glGetUniformLocation(shader.shaderProgram, "font"), 0);
+
+        std::vector<uint8_t> atlas(ATLAS_W * ATLAS_H, 0);
+        for (int g = 0; g < GLYPH_COUNT; g++) {
+            int x0 = (g % ATLAS_COLUMNS) * CELL_W;
+            int y0 = (g / ATLAS_COLUMNS) * CELL_H;
+            for (int y = 0; y < 7; y++)
+                for (int x = 0; x < 5; x++)
+                    if (glyphs[g][y] & (0x10 >> x))
+                        atlas[(y0 + y) * ATLAS_W + x0 + x] = 255;
+        }
+        std::fill(atlas.begin() + (ATLAS_H - CELL_H) * ATLAS_W, atlas.end(), (uint8_t)255);
+
+        glGenTextures(1, &fontTexture);
+        glBindTexture(GL_TEXTURE_2D, fontTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_W, ATLAS_H, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        ResourceTracker::add(ResourceTracker::Kind::Texture, fontTexture, "hud", "font", (long long)atlas.size());
+
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, u));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+        glBindVertexArray(0);
+
+        // total - available video memory (NVIDIA); other drivers do not report it
+        videoMemoryQuery = hasExtension("GL_NVX_gpu_memory_info");
+        initialized = true;
+    }
+
+    void Hud::release() {
+        if (!initialized)
+            return;
+        ResourceTracker::remove(ResourceTracker::Kind::Texture, fontTexture);
+        glDeleteBuffers(1, &vbo);
+        glDeleteVertexArrays(1, &vao);
+        glDeleteTextures(1, &fontTexture);
+        glDeleteProgram(shader.shaderProgram);
+        initialized = false;
+    }
+
+    void Hud::update(const Frame& frame) {
+        latest = frame;
+        history[historyNext] = (float)frame.frameMs;
+        historyNext = (historyNext + 1) % HISTORY;
+    }
+
+    void Hud::quad(float x0, float y0, float x1, float y1, uint32_t color) {
+        // the middle of the solid block
+        float u = 0.5f * CELL_W / ATLAS_W;
+        float v = (ATLAS_H - 0.5f * CELL_H) / ATLAS_H;
+        // counter-clockwise once y is flipped to point up
+        vertices.push_back({ x0, y0, u, v, color });
+        vertices.push_back({ x0, y1, u, v, color });
+        vertices.push_back({ x1, y1, u, v, color });
+        vertices.push_back({ x0, y0, u, v, color });
+        vertices.push_back({ x1, y1, u, v, color });
+        vertices.push_back({ x1, y0, u, v, color });
+    }
+
+    void Hud::text(float x, float y, const char* s, uint32_t color) {
+        for (; *s; s++, x += CELL_W * SCALE) {
+            int c = (unsigned char)*s;
+            if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+            if (c == ' ') continue;
+            if (c < FIRST_GLYPH || c >= FIRST_GLYPH + GLYPH_COUNT) c = '?';
+
+            int g = c - FIRST_GLYPH;
+            float u0 = (float)((g % ATLAS_COLUMNS) * CELL_W) / ATLAS_W;
+            float v0 = (float)((g / ATLAS_COLUMNS) * CELL_H) / ATLAS_H;
+            float u1 = u0 + 5.0f / ATLAS_W;
+            float v1 = v0 + 7.0f / ATLAS_H;
+            float x1 = x + 5 * SCALE;
+            float y1 = y + 7 * SCALE;
+
+            vertices.push_back({ x, y, u0, v0, color });
+            vertices.push_back({ x, y1, u0, v1, color });
+            vertices.push_back({ x1, y1, u1, v1, color });
+            vertices.push_back({ x, y, u0, v0, color });
+            vertices.push_back({ x1, y1, u1, v1, color });
+            vertices.push_back({ x1, y, u1, v0, color });
+        }
+    }
+
+    float Hud::lineWidth(const char* s) const {
+        return (float)(std::strlen(s) * CELL_W * SCALE);
+    }
+
+    static void formatBytes(char* out, size_t size, long long bytes) {
+        if (bytes < 0) std::snprintf(out, size, "n/a");
+        else std::snprintf(out, size, "%.1f MB", bytes / (1024.0 * 1024.0));
+    }
+
+    void Hud::draw(int width, int height) {
+        if (!initialized || !shown || width <= 0 || height <= 0)
+            return;
+
+        const float margin = 8.0f;
+        const float pad = 6.0f;
+        const float lineHeight = (float)(9 * SCALE);
+        const float graphHeight = 24.0f * SCALE;
+        const float barWidth = (float)SCALE;
+
+        // one line of text per entry; the graph sits below the first line
+        struct Line {
+            char text[64];
+            uint32_t color;
+        };
+        std::vector<Line> lines;
+        auto add = [&lines](uint32_t color) {
+            lines.push_back(Line());
+            lines.back().color = color;
+            return lines.back().text;
+        };
+        const size_t size = sizeof(Line::text);
+
+        std::snprintf(add(TEXT), size, "FRAME %6.2f MS  %5.0f FPS",
+            latest.frameMs, latest.frameMs > 0.0 ? 1000.0 / latest.frameMs : 0.0);
+        for (const Timing& t : latest.cpu)
+            std::snprintf(add(TEXT), size, "CPU %-10s %6.2f MS", t.name, t.ms);
+        double gpuTotal = 0.0;
+        for (const GpuProfiler::PassTime& p : latest.gpu) {
+            std::snprintf(add(TEXT), size, "GPU %-10s %6.2f MS", p.name, p.ms);
+            gpuTotal += p.ms;
+        }
+        if (!latest.gpu.empty())
+            std::snprintf(add(LABEL), size, "GPU %-10s %6.2f MS", "total", gpuTotal);
+        std::snprintf(add(TEXT), size, "DRAWS %d  TRIS %lld", latest.drawCalls, latest.triangles);
+        std::snprintf(add(TEXT), size, "MESHES %d  CULLED %d", latest.meshesDrawn, latest.meshesCulled);
+
+        char textures[32], buffers[32];
+        formatBytes(textures, sizeof(textures), latest.textureBytes);
+        formatBytes(buffers, sizeof(buffers), latest.bufferBytes);
+        std::snprintf(add(TEXT), size, "TEX %s  BUF %s", textures, buffers);
+        if (videoMemoryQuery) {
+            GLint total = 0, available = 0;
+            glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+            glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+            std::snprintf(add(TEXT), size, "VRAM %d / %d MB", (total - available) / 1024, total / 1024);
+        }
+
+        float panelWidth = HISTORY * barWidth;
+        for (const auto& l : lines)
+            panelWidth = std::max(panelWidth, lineWidth(l.text));
+        float panelHeight = lines.size() * lineHeight + graphHeight + pad;
+
+        vertices.clear();
+        quad(margin, margin, margin + panelWidth + 2 * pad, margin + panelHeight + 2 * pad, PANEL);
+
+        float x = margin + pad;
+        float y = margin + pad;
+        text(x, y, lines[0].text, lines[0].color);
+        y += lineHeight;
+
+        // frame times, oldest on the left; full height is 33.3 ms, the guide marks 16.7 ms
+        float graphBottom = y + graphHeight;
+        for (int i = 0; i < HISTORY; i++) {
+            float ms = history[(historyNext + i) % HISTORY];
+            float h = std::min(ms / 33.3f, 1.0f) * graphHeight;
+            uint32_t color = ms <= 17.0f ? GOOD : ms <= 34.0f ? SLOW : BAD;
+            quad(x + i * barWidth, graphBottom - h, x + (i + 1) * barWidth, graphBottom, color);
+        }
+        quad(x, graphBottom - graphHeight * 0.5f, x + HISTORY * barWidth, graphBottom - graphHeight * 0.5f + 1.0f, GUIDE);
+        y = graphBottom + pad;
+
+        for (size_t i = 1; i < lines.size(); i++, y += lineHeight)
+            text(x, y, lines[i].text, lines[i].color);
+
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+        shader.useShaderProgram();
+        glUniform2f(screenSizeLoc, (float)width, (float)height);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, fontTexture);
+
+        // orphan last frame's storage so the upload never waits on it
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLsizeiptr bytes = (GLsizeiptr)(vertices.size() * sizeof(Vertex));
+        glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices.data());
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+        glBindVertexArray(0);
+
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef Hud_hpp
+#define Hud_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include "Shader.hpp"
+#include "GpuProfiler.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace gps {
+
+    // frame statistics overlay. Text and quads go into one vertex buffer that is
+    // drawn with a single call, using a built-in 5x7 bitmap font whose atlas also
+    // holds a solid block for the panel and the frame time graph.
+    class Hud {
+
+    public:
+        struct Timing {
+            const char* name;
+            double ms;
+        };
+
+        struct Frame {
+            double frameMs = 0.0;
+            std::vector<Timing> cpu;
+            std::vector<GpuProfiler::PassTime> gpu;
+            int drawCalls = 0;
+            int meshesDrawn = 0;
+            int meshesCulled = 0;
+            long long triangles = 0;
+            // -1 = not known
+            long long textureBytes = -1;
+            long long bufferBytes = -1;
+        };
+
+        // loads shaders/hud.vert + hud.frag and builds the font atlas; needs the GL context
+        void init();
+        void release();
+
+        bool visible() const { return shown; }
+        void setVisible(bool visible) { shown = visible; }
+
+        // the numbers shown until the next update
+        void update(const Frame& frame);
+        // draws over whatever framebuffer is bound; leaves depth test on and blending off
+        void draw(int width, int height);
+
+    private:
+        struct Vertex {
+            float x, y;
+            float u, v;
+            uint32_t color; // RGBA8, sRGB
+        };
+
+        static const int HISTORY = 120;
+        static const int SCALE = 2; // screen pixels per font pixel
+
+        Shader shader;
+        GLint screenSizeLoc = -1;
+        GLuint fontTexture = 0;
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        bool initialized = false;
+        bool shown = false;
+        bool videoMemoryQuery = false;
+
+        Frame latest;
+        float history[HISTORY] = {};
+        int historyNext = 0;
+
+        std::vector<Vertex> vertices;
+
+        void quad(float x0, float y0, float x1, float y1, uint32_t color);
+        void text(float x, float y, const char* s, uint32_t color);
+        // pixel width of a line of text
+        float lineWidth(const char* s) const;
+    };
+}
+
+#endif /* Hud_hpp */
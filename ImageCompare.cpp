@@ -0,0 +1,100 @@
+#include "ImageCompare.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gps {
+
+    struct Lab {
+        float l, a, b;
+    };
+
+    struct SrgbTable {
+        float linear[256];
+
+        SrgbTable() {
+            for (int i = 0; i < 256; i++) {
+                float c = i / 255.0f;
+                linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+        }
+    };
+
+    static float labF(float t) {
+        return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+    }
+
+    static std::vector<Lab> toLab(const uint8_t* rgb, size_t pixels) {
+        static const SrgbTable table;
+
+        std::vector<Lab> lab(pixels);
+        for (size_t i = 0; i < pixels; i++) {
+            float r = table.linear[rgb[3 * i]];
+            float g = table.linear[rgb[3 * i + 1]];
+            float b = table.linear[rgb[3 * i + 2]];
+
+            // XYZ relative to the D65 white point
+            float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+            float y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+            float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+
+            float fx = labF(x), fy = labF(y), fz = labF(z);
+            lab[i] = Lab{ 116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz) };
+        }
+        return lab;
+    }
+
+    static float deltaE(const Lab& p, const Lab& q) {
+        float dl = p.l - q.l, da = p.a - q.a, db = p.b - q.b;
+        return std::sqrt(dl * dl + da * da + db * db);
+    }
+
+    ImageDiff ImageCompare::compare(const uint8_t* reference, const uint8_t* actual, int width, int height,
+        std::vector<uint8_t>* heatmap) {
+        ImageDiff diff;
+        size_t pixels = (size_t)width * height;
+        if (pixels == 0)
+            return diff;
+
+        std::vector<Lab> ref = toLab(reference, pixels);
+        std::vector<Lab> act = toLab(actual, pixels);
+        if (heatmap)
+            heatmap->assign(pixels * 3, 0);
+
+        size_t noticeable = 0, severe = 0;
+        double sum = 0.0;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                size_t i = (size_t)y * width + x;
+
+                // closest reference colour around the pixel
+                float e = deltaE(ref[i], act[i]);
+                for (int dy = -1; dy <= 1 && e > NOTICEABLE; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+                            continue;
+                        e = std::min(e, deltaE(ref[(size_t)ny * width + nx], act[i]));
+                    }
+                }
+
+                sum += e;
+                diff.maxDeltaE = std::max(diff.maxDeltaE, (double)e);
+                if (e > NOTICEABLE) noticeable++;
+                if (e > SEVERE) severe++;
+
+                if (heatmap) {
+                    uint8_t* h = heatmap->data() + 3 * i;
+                    if (e > SEVERE) { h[0] = 255; h[1] = 0; h[2] = 0; }
+                    else if (e > NOTICEABLE) { h[0] = 255; h[1] = 220; h[2] = 0; }
+                    else h[0] = h[1] = h[2] = (uint8_t)(act[i].l * 0.4f * 2.55f);
+                }
+            }
+        }
+
+        diff.noticeable = (double)noticeable / pixels;
+        diff.severe = (double)severe / pixels;
+        diff.meanDeltaE = sum / pixels;
+        return diff;
+    }
+}
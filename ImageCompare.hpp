@@ -0,0 +1,35 @@
+#ifndef ImageCompare_hpp
+#define ImageCompare_hpp
+
+#include <cstdint>
+#include <vector>
+
+namespace gps {
+
+    struct ImageDiff {
+        // fractions of the pixels
+        double noticeable = 0.0;
+        double severe = 0.0;
+        double maxDeltaE = 0.0;
+        double meanDeltaE = 0.0;
+    };
+
+    // perceptual difference of two 8-bit sRGB images of the same size: colour
+    // distance is CIE76 delta E in L*a*b*, and a pixel only counts as different
+    // when no pixel in the 3x3 neighbourhood of the reference matches it, so
+    // edges rasterised one pixel apart by another driver do not fail.
+    class ImageCompare {
+
+    public:
+        // just noticeable / clearly wrong (delta E)
+        static constexpr float NOTICEABLE = 2.3f;
+        static constexpr float SEVERE = 20.0f;
+
+        // rgb, rows top to bottom; heatmap, if given, gets a dimmed grey copy of
+        // actual with noticeable differences in yellow and severe ones in red
+        static ImageDiff compare(const uint8_t* reference, const uint8_t* actual, int width, int height,
+            std::vector<uint8_t>* heatmap = nullptr);
+    };
+}
+
+#endif /* ImageCompare_hpp */
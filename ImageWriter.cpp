@@ -0,0 +1,286 @@
+#include "ImageWriter.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace gps {
+
+    // deflate bit stream, least significant bit first
+    struct BitWriter {
+        std::vector<uint8_t>& out;
+        uint32_t bits = 0;
+        int count = 0;
+
+        explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+        void put(uint32_t value, int n) {
+            bits |= value << count;
+            count += n;
+            while (count >= 8) {
+                out.push_back((uint8_t)bits);
+                bits >>= 8;
+                count -= 8;
+            }
+        }
+
+        // Huffman codes are defined most significant bit first
+        void putCode(uint32_t code, int n) {
+            uint32_t reversed = 0;
+            for (int i = 0; i < n; i++)
+                reversed |= ((code >> i) & 1) << (n - 1 - i);
+            put(reversed, n);
+        }
+
+        void flush() {
+            if (count > 0)
+                out.push_back((uint8_t)bits);
+            bits = 0;
+            count = 0;
+        }
+    };
+
+    static const int LENGTH_BASE[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const int LENGTH_EXTRA[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const int DIST_BASE[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const int DIST_EXTRA[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    // fixed Huffman code of a literal/length symbol (RFC 1951 3.2.6)
+    static void putSymbol(BitWriter& w, int symbol) {
+        if (symbol <= 143) w.putCode(0x30 + symbol, 8);
+        else if (symbol <= 255) w.putCode(0x190 + symbol - 144, 9);
+        else if (symbol <= 279) w.putCode(symbol - 256, 7);
+        else w.putCode(0xc0 + symbol - 280, 8);
+    }
+
+    static void putMatch(BitWriter& w, int length, int distance) {
+        int l = 28;
+        while (LENGTH_BASE[l] > length) l--;
+        putSymbol(w, 257 + l);
+        w.put(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+        int d = 29;
+        while (DIST_BASE[d] > distance) d--;
+        w.putCode(d, 5);
+        w.put(distance - DIST_BASE[d], DIST_EXTRA[d]);
+    }
+
+    static uint32_t adler32(const uint8_t* data, size_t size) {
+        uint32_t a = 1, b = 0;
+        while (size > 0) {
+            // largest run before b can overflow
+            size_t run = size < 5552 ? size : 5552;
+            size -= run;
+            while (run--) {
+                a += *data++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return b << 16 | a;
+    }
+
+    std::vector<uint8_t> ImageWriter::compress(const uint8_t* data, size_t size) {
+        const int WINDOW = 32768;
+        const int HASH_BITS = 15;
+        const int MAX_CHAIN = 24;
+        const int MIN_MATCH = 3;
+        const int MAX_MATCH = 258;
+
+        std::vector<uint8_t> out;
+        out.reserve(size / 2 + 64);
+        out.push_back(0x78); // deflate, 32K window
+        out.push_back(0x01);
+
+        BitWriter w(out);
+        w.put(1, 1); // final block
+        w.put(1, 2); // fixed Huffman codes
+
+        std::vector<int32_t> head((size_t)1 << HASH_BITS, -1);
+        std::vector<int32_t> prev(size);
+        auto hash = [data](size_t p) {
+            uint32_t v = (uint32_t)data[p] << 16 | (uint32_t)data[p + 1] << 8 | data[p + 2];
+            return (v * 2654435761u) >> (32 - HASH_BITS);
+        };
+        auto insert = [&](size_t p) {
+            uint32_t h = hash(p);
+            prev[p] = head[h];
+            head[h] = (int32_t)p;
+        };
+
+        size_t i = 0;
+        while (i < size) {
+            int best = 0;
+            int bestDistance = 0;
+
+            if (i + MIN_MATCH <= size) {
+                int limit = (int)(size - i < (size_t)MAX_MATCH ? size - i : MAX_MATCH);
+                int32_t candidate = head[hash(i)];
+                for (int chain = 0; candidate >= 0 && (int)(i - candidate) <= WINDOW && chain < MAX_CHAIN; chain++) {
+                    const uint8_t* a = data + candidate;
+                    const uint8_t* b = data + i;
+                    if (a[best] == b[best]) {
+                        int length = 0;
+                        while (length < limit && a[length] == b[length]) length++;
+                        if (length > best) {
+                            best = length;
+                            bestDistance = (int)(i - candidate);
+                            if (length == limit) break;
+                        }
+                    }
+                    candidate = prev[candidate];
+                }
+                insert(i);
+            }
+
+            if (best >= MIN_MATCH) {
+                putMatch(w, best, bestDistance);
+                for (size_t p = i + 1; p < i + best && p + MIN_MATCH <= size; p++)
+                    insert(p);
+                i += best;
+            }
+            else {
+                putSymbol(w, data[i]);
+                i++;
+            }
+        }
+        putSymbol(w, 256); // end of block
+        w.flush();
+
+        uint32_t check = adler32(data, size);
+        for (int s = 24; s >= 0; s -= 8)
+            out.push_back((uint8_t)(check >> s));
+        return out;
+    }
+
+    struct CrcTable {
+        uint32_t entries[256];
+
+        CrcTable() {
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++)
+                    c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                entries[n] = c;
+            }
+        }
+    };
+
+    static uint32_t crc32(const uint8_t* data, size_t size) {
+        // encoders run on several workers at once; a function-local static is built exactly once
+        static const CrcTable table;
+
+        uint32_t crc = 0xffffffffu;
+        for (size_t i = 0; i < size; i++)
+            crc = table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    static void putBigEndian(std::vector<uint8_t>& out, uint32_t v) {
+        for (int s = 24; s >= 0; s -= 8)
+            out.push_back((uint8_t)(v >> s));
+    }
+
+    static void putChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data) {
+        putBigEndian(png, (uint32_t)data.size());
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        putBigEndian(png, crc32(png.data() + start, png.size() - start));
+    }
+
+    static int paeth(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return a;
+        return pb <= pc ? b : c;
+    }
+
+    std::vector<uint8_t> ImageWriter::encodePng(int width, int height, const uint8_t* rgb) {
+        const int bpp = 3;
+        const size_t stride = (size_t)width * bpp;
+
+        // each row gets the filter with the smallest sum of absolute residuals
+        std::vector<uint8_t> filtered(height * (stride + 1));
+        std::vector<uint8_t> candidates[5];
+        for (auto& c : candidates) c.resize(stride);
+        std::vector<uint8_t> zeroRow(stride, 0);
+
+        for (int y = 0; y < height; y++) {
+            const uint8_t* row = rgb + y * stride;
+            const uint8_t* up = y > 0 ? row - stride : zeroRow.data();
+
+            for (size_t x = 0; x < stride; x++) {
+                int a = x >= bpp ? row[x - bpp] : 0;
+                int b = up[x];
+                int c = x >= bpp ? up[x - bpp] : 0;
+                candidates[0][x] = row[x];
+                candidates[1][x] = (uint8_t)(row[x] - a);
+                candidates[2][x] = (uint8_t)(row[x] - b);
+                candidates[3][x] = (uint8_t)(row[x] - ((a + b) >> 1));
+                candidates[4][x] = (uint8_t)(row[x] - paeth(a, b, c));
+            }
+
+            int bestFilter = 0;
+            long long bestCost = -1;
+            for (int f = 0; f < 5; f++) {
+                long long cost = 0;
+                for (size_t x = 0; x < stride; x++)
+                    cost += std::abs((int)(int8_t)candidates[f][x]);
+                if (bestCost < 0 || cost < bestCost) {
+                    bestCost = cost;
+                    bestFilter = f;
+                }
+            }
+
+            uint8_t* out = filtered.data() + y * (stride + 1);
+            out[0] = (uint8_t)bestFilter;
+            std::memcpy(out + 1, candidates[bestFilter].data(), stride);
+        }
+
+        std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+        std::vector<uint8_t> header;
+        putBigEndian(header, (uint32_t)width);
+        putBigEndian(header, (uint32_t)height);
+        header.push_back(8); // bits per channel
+        header.push_back(2); // RGB
+        header.push_back(0); // deflate
+        header.push_back(0); // adaptive filtering
+        header.push_back(0); // not interlaced
+        putChunk(png, "IHDR", header);
+        putChunk(png, "IDAT", compress(filtered.data(), filtered.size()));
+        putChunk(png, "IEND", std::vector<uint8_t>());
+        return png;
+    }
+
+    static bool writeFile(const std::string& fileName, const uint8_t* data, size_t size) {
+        std::ofstream out(fileName, std::ios::binary);
+        if (out)
+            out.write((const char*)data, size);
+        if (!out) {
+            std::cout << "ERROR: could not write " << fileName << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool ImageWriter::writePng(const std::string& fileName, int width, int height, const uint8_t* rgb) {
+        std::vector<uint8_t> png = encodePng(width, height, rgb);
+        return writeFile(fileName, png.data(), png.size());
+    }
+
+    bool ImageWriter::writeRaw(const std::string& fileName, int width, int height, const uint8_t* rgb) {
+        return writeFile(fileName, rgb, (size_t)width * height * 3);
+    }
+}
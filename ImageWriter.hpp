@@ -0,0 +1,26 @@
+#ifndef ImageWriter_hpp
+#define ImageWriter_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gps {
+
+    // 8-bit RGB images (rows top to bottom) to PNG or raw files. The PNG encoder
+    // picks a filter per row and compresses with fixed-Huffman deflate and a
+    // hash-chain match finder: quick enough to run on a worker per frame.
+    class ImageWriter {
+
+    public:
+        static std::vector<uint8_t> encodePng(int width, int height, const uint8_t* rgb);
+        static bool writePng(const std::string& fileName, int width, int height, const uint8_t* rgb);
+        // bare pixels, e.g. for ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH
+        static bool writeRaw(const std::string& fileName, int width, int height, const uint8_t* rgb);
+
+        // zlib stream (RFC 1950) of data
+        static std::vector<uint8_t> compress(const uint8_t* data, size_t size);
+    };
+}
+
+#endif /* ImageWriter_hpp */
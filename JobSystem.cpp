@@ -0,0 +1,238 @@
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace gps {
+
+    // which system/queue the calling thread is a worker of
+    static thread_local const JobSystem* currentSystem = nullptr;
+    static thread_local int currentIndex = 0;
+
+    JobSystem::~JobSystem() {
+        stop();
+    }
+
+    void JobSystem::start(int workerCount) {
+        stop();
+        quit = false;
+
+        queues.clear();
+        for (int i = 0; i < workerCount + 1; i++)
+            queues.emplace_back(new Queue());
+
+        for (int i = 0; i < workerCount; i++)
+            workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+    }
+
+    void JobSystem::stop() {
+        // finish what was queued; outside threads may still be waiting on it
+        while (queued.load() > 0 && runOne(currentQueue())) {}
+
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+        workers.clear();
+    }
+
+    int JobSystem::currentQueue() const {
+        return currentSystem == this ? currentIndex : 0;
+    }
+
+    void JobSystem::run(std::function<void()> job, JobCounter* counter) {
+        if (counter)
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+        // not started: behave like a serial loop
+        if (queues.empty()) {
+            job();
+            if (counter) counter->pending.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+
+        Queue& q = *queues[currentQueue()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.jobs.push_back(Job{ std::move(job), counter });
+        }
+        queued.fetch_add(1);
+
+        if (!workers.empty()) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+    }
+
+    bool JobSystem::popOwn(int self, Job& job) {
+        Queue& q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.jobs.empty())
+            return false;
+
+        // newest first: its data is most likely still in cache
+        job = std::move(q.jobs.back());
+        q.jobs.pop_back();
+        return true;
+    }
+
+    bool JobSystem::steal(int self, Job& job) {
+        const int n = (int)queues.size();
+        for (int k = 1; k < n; k++) {
+            Queue& q = *queues[(self + k) % n];
+            std::unique_lock<std::mutex> lock(q.mutex, std::try_to_lock);
+            if (!lock.owns_lock() || q.jobs.empty())
+                continue;
+
+            // oldest first: usually the biggest piece of a split range
+            job = std::move(q.jobs.front());
+            q.jobs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool JobSystem::runOne(int self) {
+        if (queues.empty())
+            return false;
+
+        Job job;
+        if (!popOwn(self, job) && !steal(self, job))
+            return false;
+
+        queued.fetch_sub(1);
+        job.fn();
+        if (job.counter)
+            job.counter->pending.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    void JobSystem::wait(JobCounter& counter) {
+        const int self = currentQueue();
+        while (!counter.done()) {
+            if (!runOne(self))
+                std::this_thread::yield();
+        }
+    }
+
+    void JobSystem::parallelFor(int first, int last, int grain, const std::function<void(int, int)>& body) {
+        if (last <= first)
+            return;
+
+        grain = std::max(grain, 1);
+        if (workers.empty() || last - first <= grain) {
+            for (int b = first; b < last; b += grain)
+                body(b, std::min(b + grain, last));
+            return;
+        }
+
+        JobCounter counter;
+        for (int b = first + grain; b < last; b += grain) {
+            int end = std::min(b + grain, last);
+            run([&body, b, end] { body(b, end); }, &counter);
+        }
+
+        // the caller takes the first chunk itself
+        body(first, std::min(first + grain, last));
+        wait(counter);
+    }
+
+    void JobSystem::workerLoop(int index) {
+        currentSystem = this;
+        currentIndex = index;
+        Profiler::setThreadName("worker");
+
+        for (;;) {
+            if (runOne(index))
+                continue;
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return quit || queued.load() > 0; });
+            if (quit && queued.load() == 0)
+                return;
+        }
+    }
+
+    void JobSystem::benchmark(int maxThreads) {
+        typedef std::chrono::steady_clock clock;
+        auto ms = [](clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        };
+
+        // a few hundred ns of arithmetic per element
+        auto work = [](int i) {
+            float x = (float)i;
+            for (int k = 0; k < 64; k++) x = std::sin(x) * 0.5f + (float)k;
+            return x;
+        };
+
+        const int elements = 1 << 20;
+        std::vector<float> out(elements);
+
+        std::cout << "Job system, 1.." << maxThreads << " threads" << std::endl;
+
+        double base[4] = {};
+        for (int threads = 1; threads <= maxThreads; threads++) {
+            JobSystem jobs;
+            jobs.start(threads - 1);
+
+            // 1. overhead of tiny jobs
+            const int tiny = 200000;
+            std::atomic<int> sink{ 0 };
+            JobCounter counter;
+            auto start = clock::now();
+            for (int i = 0; i < tiny; i++)
+                jobs.run([&sink] { sink.fetch_add(1, std::memory_order_relaxed); }, &counter);
+            jobs.wait(counter);
+            double tinyMs = ms(start);
+
+            // 2. parallelFor over uniform work
+            start = clock::now();
+            jobs.parallelFor(0, elements, 4096, [&](int b, int e) {
+                for (int i = b; i < e; i++) out[i] = work(i);
+            });
+            double forMs = ms(start);
+
+            // 3. nested: each job splits itself until small enough
+            std::function<void(int, int, JobCounter&)> split = [&](int b, int e, JobCounter& parent) {
+                if (e - b <= 2048) {
+                    for (int i = b; i < e; i++) out[i] = work(i);
+                    return;
+                }
+                int mid = (b + e) / 2;
+                jobs.run([&split, b, mid, &parent] { split(b, mid, parent); }, &parent);
+                split(mid, e, parent);
+            };
+            JobCounter root;
+            start = clock::now();
+            split(0, elements, root);
+            jobs.wait(root);
+            double nestedMs = ms(start);
+
+            // 4. uneven: element cost grows along the range, so static splits would idle
+            start = clock::now();
+            jobs.parallelFor(0, 4096, 16, [&](int b, int e) {
+                for (int i = b; i < e; i++) {
+                    float sum = 0.0f;
+                    for (int k = 0; k < i / 8; k++) sum += work(i + k);
+                    out[i] = sum;
+                }
+            });
+            double unevenMs = ms(start);
+
+            double t[4] = { tinyMs, forMs, nestedMs, unevenMs };
+            if (threads == 1) for (int k = 0; k < 4; k++) base[k] = t[k];
+
+            std::cout << "  " << threads << " thread(s): "
+                << tiny / tinyMs / 1000.0 << " M tiny jobs/s, "
+                << "parallelFor " << forMs << " ms (" << base[1] / forMs << "x), "
+                << "nested " << nestedMs << " ms (" << base[2] / nestedMs << "x), "
+                << "uneven " << unevenMs << " ms (" << base[3] / unevenMs << "x)" << std::endl;
+        }
+    }
+}
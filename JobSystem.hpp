@@ -0,0 +1,80 @@
+#ifndef JobSystem_hpp
+#define JobSystem_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gps {
+
+    // number of unfinished jobs a caller is waiting for; jobs started with a
+    // counter add 1 to it and remove 1 when they return, so a job can start
+    // children on its own counter and wait for them (parent/child)
+    class JobCounter {
+
+    public:
+        bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        std::atomic<int> pending{ 0 };
+    };
+
+    // work-stealing scheduler: every worker owns a deque, pushes and pops its own
+    // jobs at the back and steals from the front of the others when it runs dry.
+    // Threads outside the system (render, simulation) submit through a shared queue
+    // and help run jobs while they wait, so a system with N workers uses N + 1 cores.
+    class JobSystem {
+
+    public:
+        ~JobSystem();
+
+        // 0 workers is valid: every job then runs inside wait()
+        void start(int workerCount);
+        void stop();
+        int threadCount() const { return (int)workers.size() + 1; }
+
+        void run(std::function<void()> job, JobCounter* counter = nullptr);
+        // runs queued jobs until counter reaches zero
+        void wait(JobCounter& counter);
+
+        // body(begin, end) over [first, last) in chunks of at most grain; returns when all are done
+        void parallelFor(int first, int last, int grain, const std::function<void(int, int)>& body);
+
+        // job overhead, parallelFor scaling, nested jobs and uneven work on 1..maxThreads threads
+        static void benchmark(int maxThreads);
+
+    private:
+        struct Job {
+            std::function<void()> fn;
+            JobCounter* counter;
+        };
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        // queues[0] is shared by outside threads, queues[i + 1] belongs to worker i
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        std::atomic<int> queued{ 0 };
+        bool quit = false;
+
+        int currentQueue() const;
+        bool popOwn(int self, Job& job);
+        bool steal(int self, Job& job);
+        bool runOne(int self);
+        void workerLoop(int index);
+    };
+}
+
+#endif /* JobSystem_hpp */
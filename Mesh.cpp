@@ -1,4 +1,5 @@
 #include "Mesh.hpp"
+#include "GLStatsHooks.hpp"
 
 namespace gps {
 
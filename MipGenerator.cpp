@@ -0,0 +1,314 @@
+#include "MipGenerator.hpp"
+#include "Profiler.hpp"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GPS_MIP_SIMD 1
+#endif
+
+namespace gps {
+
+    MipGenerator::Filter MipGenerator::filter = MipGenerator::Filter::Kaiser;
+
+    static const float PI = 3.14159265f;
+    static const float KAISER_RADIUS = 3.0f; // in texels of the smaller level
+    static const float KAISER_ALPHA = 4.0f;
+    // linear values are quantized to 13 bits before the table lookup (< 0.5 steps of error)
+    static const int ENCODE_SIZE = 1 << 13;
+
+    static float srgbToLinear(float c) {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static float linearToSrgb(float c) {
+        return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    struct ColorTables {
+        float srgbDecode[256];
+        float unormDecode[256];
+        uint8_t srgbEncode[ENCODE_SIZE];
+
+        ColorTables() {
+            for (int i = 0; i < 256; i++) {
+                srgbDecode[i] = srgbToLinear(i / 255.0f);
+                unormDecode[i] = i / 255.0f;
+            }
+            for (int i = 0; i < ENCODE_SIZE; i++)
+                srgbEncode[i] = (uint8_t)(linearToSrgb(i / (float)(ENCODE_SIZE - 1)) * 255.0f + 0.5f);
+        }
+    };
+
+    static const ColorTables& tables() {
+        static const ColorTables t;
+        return t;
+    }
+
+    // for every texel of the smaller level, `count` source texels and weights summing to 1
+    struct Taps {
+        int count = 0;
+        std::vector<int> index;
+        std::vector<float> weight;
+    };
+
+    static float besselI0(float x) {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 20; k++) {
+            float f = x / (2.0f * k);
+            term *= f * f;
+            sum += term;
+        }
+        return sum;
+    }
+
+    // t in texels of the smaller level
+    static float kaiser(float t) {
+        if (std::fabs(t) >= KAISER_RADIUS)
+            return 0.0f;
+        float sinc = t == 0.0f ? 1.0f : std::sin(PI * t) / (PI * t);
+        float r = t / KAISER_RADIUS;
+        return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0f - r * r)) / besselI0(KAISER_ALPHA);
+    }
+
+    static Taps computeTaps(int srcSize, int dstSize, MipGenerator::Filter filter) {
+        float scale = (float)srcSize / dstSize;
+        float radius = (filter == MipGenerator::Filter::Box ? 0.5f : KAISER_RADIUS) * scale;
+
+        std::vector<std::vector<std::pair<int, float>>> lists(dstSize);
+        Taps taps;
+        for (int d = 0; d < dstSize; d++) {
+            float center = (d + 0.5f) * scale;
+            float sum = 0.0f;
+            for (int i = (int)std::floor(center - radius); i < center + radius; i++) {
+                float w = filter == MipGenerator::Filter::Box
+                    ? std::min((float)i + 1.0f, center + radius) - std::max((float)i, center - radius)
+                    : kaiser((i + 0.5f - center) / scale);
+                if (w == 0.0f)
+                    continue;
+                // the textures repeat, so the filter wraps around the edges
+                lists[d].push_back({ ((i % srcSize) + srcSize) % srcSize, w });
+                sum += w;
+            }
+            for (auto& tap : lists[d])
+                tap.second /= sum;
+            taps.count = std::max(taps.count, (int)lists[d].size());
+        }
+
+        taps.index.assign((size_t)dstSize * taps.count, 0);
+        taps.weight.assign((size_t)dstSize * taps.count, 0.0f);
+        for (int d = 0; d < dstSize; d++) {
+            for (size_t k = 0; k < lists[d].size(); k++) {
+                taps.index[(size_t)d * taps.count + k] = lists[d][k].first;
+                taps.weight[(size_t)d * taps.count + k] = lists[d][k].second;
+            }
+        }
+        return taps;
+    }
+
+    // linear RGBA floats -> RGBA8, through the sRGB table for colour
+    static void encodeRow(const float* linear, int texels, bool srgb, uint8_t* out) {
+        const uint8_t* table = tables().srgbEncode;
+#if defined(GPS_MIP_SIMD)
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        const float top = (float)(ENCODE_SIZE - 1);
+        const __m128 scale = srgb ? _mm_setr_ps(top, top, top, 255.0f) : _mm_set1_ps(255.0f);
+        alignas(16) int32_t q[4];
+        for (int i = 0; i < texels; i++, out += 4) {
+            __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(linear + 4 * i), zero), one);
+            // rounds to nearest
+            _mm_store_si128((__m128i*)q, _mm_cvtps_epi32(_mm_mul_ps(v, scale)));
+            for (int k = 0; k < 3; k++)
+                out[k] = srgb ? table[q[k]] : (uint8_t)q[k];
+            out[3] = (uint8_t)q[3];
+        }
+#else
+        for (int i = 0; i < texels; i++, out += 4) {
+            for (int k = 0; k < 4; k++) {
+                float v = std::min(1.0f, std::max(0.0f, linear[4 * i + k]));
+                out[k] = (srgb && k < 3) ? table[(int)(v * (ENCODE_SIZE - 1) + 0.5f)] : (uint8_t)(v * 255.0f + 0.5f);
+            }
+        }
+#endif
+    }
+
+    void MipGenerator::downsample(const uint8_t* rgba, int width, int height, bool srgb, std::vector<uint8_t>& out, JobSystem* jobs) {
+        PROFILE_ZONE("MipGenerator::downsample");
+        const ColorTables& t = tables();
+        int w = std::max(1, width / 2), h = std::max(1, height / 2);
+        Taps tx = computeTaps(width, w, filter);
+        Taps ty = computeTaps(height, h, filter);
+        const float* rgbDecode = srgb ? t.srgbDecode : t.unormDecode;
+
+        // 1. every source row decoded to linear and filtered horizontally (height x w)
+        std::vector<float> rows((size_t)height * w * 4);
+        auto horizontal = [&](int first, int last) {
+            std::vector<float> line((size_t)width * 4);
+            for (int y = first; y < last; y++) {
+                const uint8_t* src = rgba + (size_t)y * width * 4;
+                for (int i = 0; i < width * 4; i += 4) {
+                    line[i] = rgbDecode[src[i]];
+                    line[i + 1] = rgbDecode[src[i + 1]];
+                    line[i + 2] = rgbDecode[src[i + 2]];
+                    line[i + 3] = t.unormDecode[src[i + 3]];
+                }
+
+                float* dst = rows.data() + (size_t)y * w * 4;
+                for (int x = 0; x < w; x++) {
+                    const int* index = tx.index.data() + (size_t)x * tx.count;
+                    const float* weight = tx.weight.data() + (size_t)x * tx.count;
+#if defined(GPS_MIP_SIMD)
+                    __m128 acc = _mm_setzero_ps();
+                    for (int k = 0; k < tx.count; k++)
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(line.data() + 4 * index[k]), _mm_set1_ps(weight[k])));
+                    _mm_storeu_ps(dst + 4 * x, acc);
+#else
+                    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                    for (int k = 0; k < tx.count; k++)
+                        for (int c = 0; c < 4; c++)
+                            acc[c] += line[4 * index[k] + c] * weight[k];
+                    std::copy(acc, acc + 4, dst + 4 * x);
+#endif
+                }
+            }
+        };
+
+        // 2. filtered vertically and encoded (h x w)
+        out.resize((size_t)w * h * 4);
+        auto vertical = [&](int first, int last) {
+            std::vector<float> acc((size_t)w * 4);
+            for (int y = first; y < last; y++) {
+                std::fill(acc.begin(), acc.end(), 0.0f);
+                for (int k = 0; k < ty.count; k++) {
+                    float weight = ty.weight[(size_t)y * ty.count + k];
+                    if (weight == 0.0f)
+                        continue;
+                    const float* row = rows.data() + (size_t)ty.index[(size_t)y * ty.count + k] * w * 4;
+#if defined(GPS_MIP_SIMD)
+                    __m128 wk = _mm_set1_ps(weight);
+                    for (int i = 0; i < w * 4; i += 4)
+                        _mm_storeu_ps(&acc[i], _mm_add_ps(_mm_loadu_ps(&acc[i]), _mm_mul_ps(_mm_loadu_ps(row + i), wk)));
+#else
+                    for (int i = 0; i < w * 4; i++)
+                        acc[i] += row[i] * weight;
+#endif
+                }
+                encodeRow(acc.data(), w, srgb, out.data() + (size_t)y * w * 4);
+            }
+        };
+
+        // about 64K source texels per job
+        int rowGrain = std::max(1, 65536 / width);
+        if (jobs) {
+            jobs->parallelFor(0, height, rowGrain, horizontal);
+            jobs->parallelFor(0, h, rowGrain, vertical);
+        }
+        else {
+            horizontal(0, height);
+            vertical(0, h);
+        }
+    }
+
+    std::vector<MipGenerator::Level> MipGenerator::generate(const uint8_t* rgba, int width, int height, bool srgb, JobSystem* jobs) {
+        PROFILE_ZONE("MipGenerator::generate");
+        std::vector<Level> levels;
+        const uint8_t* previous = rgba;
+        while (width > 1 || height > 1) {
+            Level level;
+            downsample(previous, width, height, srgb, level.rgba, jobs);
+            width = level.width = std::max(1, width / 2);
+            height = level.height = std::max(1, height / 2);
+            levels.push_back(std::move(level));
+            previous = levels.back().rgba.data();
+        }
+        return levels;
+    }
+
+    void MipGenerator::benchmark(const std::string& fileName, int maxThreads) {
+        typedef std::chrono::steady_clock clock;
+        auto ms = [](clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        };
+
+        int width, height, n;
+        unsigned char* rgba = stbi_load(fileName.c_str(), &width, &height, &n, 4);
+        if (!rgba) {
+            std::cout << "ERROR: could not load " << fileName << std::endl;
+            return;
+        }
+        std::cout << "Mip generation: " << fileName << " " << width << "x" << height
+#if defined(GPS_MIP_SIMD)
+            << ", SSE2" << std::endl;
+#else
+            << ", scalar" << std::endl;
+#endif
+
+        // reference for level 1: 2x2 box with exact sRGB conversions (pow per channel)
+        int w = std::max(1, width / 2), h = std::max(1, height / 2);
+        std::vector<uint8_t> exact((size_t)w * h * 4);
+        auto start = clock::now();
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                for (int k = 0; k < 4; k++) {
+                    float sum = 0.0f;
+                    for (int dy = 0; dy < 2; dy++) {
+                        for (int dx = 0; dx < 2; dx++) {
+                            int sx = std::min(2 * x + dx, width - 1), sy = std::min(2 * y + dy, height - 1);
+                            float v = rgba[((size_t)sy * width + sx) * 4 + k] / 255.0f;
+                            sum += k < 3 ? srgbToLinear(v) : v;
+                        }
+                    }
+                    float v = k < 3 ? linearToSrgb(sum * 0.25f) : sum * 0.25f;
+                    exact[((size_t)y * w + x) * 4 + k] = (uint8_t)(std::min(1.0f, std::max(0.0f, v)) * 255.0f + 0.5f);
+                }
+            }
+        }
+        double exactMs = ms(start);
+
+        Filter saved = filter;
+        JobSystem jobs;
+        jobs.start(maxThreads - 1);
+
+        filter = Filter::Box;
+        std::vector<uint8_t> box;
+        start = clock::now();
+        downsample(rgba, width, height, true, box, nullptr);
+        double boxMs = ms(start);
+        int maxDiff = 0;
+        double sumDiff = 0.0;
+        for (size_t i = 0; i < box.size(); i++) {
+            int d = std::abs((int)box[i] - (int)exact[i]);
+            maxDiff = std::max(maxDiff, d);
+            sumDiff += d;
+        }
+        std::cout << "  level 1 box: " << boxMs << " ms with tables, " << exactMs << " ms with pow ("
+            << exactMs / boxMs << "x), max difference " << maxDiff << ", mean " << sumDiff / box.size() << std::endl;
+
+        const Filter filters[] = { Filter::Box, Filter::Kaiser };
+        for (Filter f : filters) {
+            filter = f;
+            start = clock::now();
+            std::vector<Level> single = generate(rgba, width, height, true, nullptr);
+            double singleMs = ms(start);
+            start = clock::now();
+            std::vector<Level> parallel = generate(rgba, width, height, true, &jobs);
+            double parallelMs = ms(start);
+
+            bool same = single.size() == parallel.size();
+            for (size_t l = 0; same && l < single.size(); l++)
+                same = single[l].rgba == parallel[l].rgba;
+            std::cout << "  " << (f == Filter::Box ? "box" : "kaiser") << " chain (" << single.size() << " levels): "
+                << singleMs << " ms on 1 thread, " << parallelMs << " ms on " << jobs.threadCount()
+                << (same ? "" : ", differs from the 1 thread result") << std::endl;
+        }
+
+        filter = saved;
+        stbi_image_free(rgba);
+    }
+}
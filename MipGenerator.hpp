@@ -0,0 +1,47 @@
+#ifndef MipGenerator_hpp
+#define MipGenerator_hpp
+
+#include "JobSystem.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gps {
+
+    // builds RGBA8 mip chains on the CPU instead of glGenerateMipmap. Colour is
+    // filtered as linear light (sRGB decoded and encoded through tables), the
+    // filter is separable and wraps at the edges like the REPEAT textures it
+    // feeds. Texels are filtered four channels at a time with SSE2 and rows are
+    // split across the job system.
+    class MipGenerator {
+
+    public:
+        // Box averages the texels under each new texel; Kaiser is a windowed sinc
+        // (radius 3, alpha 4) that keeps distant mips sharper
+        enum class Filter { Box, Kaiser };
+
+        struct Level {
+            int width = 0;
+            int height = 0;
+            std::vector<uint8_t> rgba;
+        };
+
+        // the next level, max(1, width / 2) x max(1, height / 2)
+        static void downsample(const uint8_t* rgba, int width, int height, bool srgb, std::vector<uint8_t>& out, JobSystem* jobs);
+
+        // levels 1.. down to 1x1 (level 0 is the input)
+        static std::vector<Level> generate(const uint8_t* rgba, int width, int height, bool srgb, JobSystem* jobs);
+
+        static void setFilter(Filter f) { filter = f; }
+        static Filter currentFilter() { return filter; }
+
+        // chain times per filter and thread count, and the table encoder against exact sRGB
+        static void benchmark(const std::string& fileName, int maxThreads);
+
+    private:
+        static Filter filter;
+    };
+}
+
+#endif /* MipGenerator_hpp */
@@ -1,7 +1,16 @@
 #include "Model3D.hpp"
+#include "Profiler.hpp"
+#include "ResourceTracker.hpp"
+#include "TextureCache.hpp"
+#include "MipGenerator.hpp"
+#include "GLStatsHooks.hpp"
 
 namespace gps {
 
+    gps::JobSystem* Model3D::jobs = nullptr;
+    DrawStats Model3D::stats;
+    bool Model3D::compressTextures = true;
+
     void Model3D::LoadModel(std::string fileName) {
         std::string basePath = fileName.substr(0, fileName.find_last_of('/')) + "/";
         ReadOBJ(fileName, basePath);
@@ -12,21 +21,76 @@ namespace gps {
     }
 
     void Model3D::Draw(gps::Shader shaderProgram) {
-        for (int i = 0; i < meshes.size(); i++)
+        for (int i = 0; i < meshes.size(); i++) {
             meshes[i].Draw(shaderProgram);
+            stats.meshesDrawn++;
+            stats.triangles += meshes[i].indices.size() / 3;
+        }
+    }
+
+    void Model3D::Draw(gps::Shader shaderProgram, const glm::mat4& mvp) {
+        // frustum planes in model space (Gribb/Hartmann), inside where dot(plane, p) >= 0
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; i++)
+            rows[i] = glm::vec4(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+        const glm::vec4 planes[6] = {
+            rows[3] + rows[0], rows[3] - rows[0],
+            rows[3] + rows[1], rows[3] - rows[1],
+            rows[3] + rows[2], rows[3] - rows[2]
+        };
+
+        meshVisible.resize(meshes.size());
+        auto cull = [&](int first, int last) {
+            for (int i = first; i < last; i++) {
+                const gps::AABB& b = meshBounds[i];
+                unsigned char visible = 1;
+                for (const glm::vec4& p : planes) {
+                    // corner furthest along the plane normal
+                    glm::vec3 corner(p.x > 0.0f ? b.max.x : b.min.x,
+                        p.y > 0.0f ? b.max.y : b.min.y,
+                        p.z > 0.0f ? b.max.z : b.min.z);
+                    if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0.0f) {
+                        visible = 0;
+                        break;
+                    }
+                }
+                meshVisible[i] = visible;
+            }
+        };
+
+        if (jobs && meshes.size() >= 256)
+            jobs->parallelFor(0, (int)meshes.size(), 64, cull);
+        else
+            cull(0, (int)meshes.size());
+
+        for (size_t i = 0; i < meshes.size(); i++) {
+            if (!meshVisible[i]) {
+                stats.meshesCulled++;
+                continue;
+            }
+            meshes[i].Draw(shaderProgram);
+            stats.meshesDrawn++;
+            stats.triangles += meshes[i].indices.size() / 3;
+        }
     }
 
     void Model3D::ReadOBJ(std::string fileName, std::string basePath) {
+        PROFILE_ZONE("Model3D::ReadOBJ");
 
         std::cout << "Loading : " << fileName << std::endl;
+        this->fileName = fileName;
 
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
         std::string err;
 
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err,
-            fileName.c_str(), basePath.c_str(), GL_TRUE);
+        bool ret;
+        {
+            PROFILE_ZONE("tinyobj::LoadObj");
+            ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err,
+                fileName.c_str(), basePath.c_str(), GL_TRUE);
+        }
 
         if (!err.empty()) {
             std::cerr << err << std::endl;
@@ -38,13 +102,22 @@ namespace gps {
         std::cout << "# of shapes    : " << shapes.size() << std::endl;
         std::cout << "# of materials : " << materials.size() << std::endl;
 
-        for (size_t s = 0; s < shapes.size(); s++) {
-
+        // vertex data of every shape is built in parallel; materials, textures
+        // and GL buffers are then created in order on this thread
+        struct ShapeGeometry {
             std::vector<gps::Vertex> vertices;
             std::vector<GLuint> indices;
-            std::vector<gps::Texture> textures;
-
-            glm::vec3 materialDiffuse(1.0f, 1.0f, 1.0f);
+            gps::AABB bounds;
+        };
+        std::vector<ShapeGeometry> geometry(shapes.size());
+
+        auto buildShape = [&](size_t s) {
+            PROFILE_ZONE("build shape");
+            std::vector<gps::Vertex>& vertices = geometry[s].vertices;
+            std::vector<GLuint>& indices = geometry[s].indices;
+            glm::vec3 lo(1e30f), hi(-1e30f);
+            vertices.reserve(shapes[s].mesh.indices.size());
+            indices.reserve(shapes[s].mesh.indices.size());
 
             size_t index_offset = 0;
             for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
@@ -77,6 +150,9 @@ namespace gps {
                     currentVertex.Normal = glm::vec3(nx, ny, nz);
                     currentVertex.TexCoords = glm::vec2(tx, ty);
 
+                    lo = glm::min(lo, currentVertex.Position);
+                    hi = glm::max(hi, currentVertex.Position);
+
                     vertices.push_back(currentVertex);
                     indices.push_back((GLuint)(index_offset + v));
                 }
@@ -84,12 +160,33 @@ namespace gps {
                 index_offset += fv;
             }
 
+            geometry[s].bounds = gps::AABB{ lo, hi };
+        };
+
+        if (jobs) {
+            jobs->parallelFor(0, (int)shapes.size(), 1, [&](int first, int last) {
+                for (int s = first; s < last; s++) buildShape(s);
+            });
+        }
+        else {
+            for (size_t s = 0; s < shapes.size(); s++) buildShape(s);
+        }
+
+        for (size_t s = 0; s < shapes.size(); s++) {
+
+            std::vector<gps::Texture> textures;
+
+            glm::vec3 materialDiffuse(1.0f, 1.0f, 1.0f);
+            std::string materialName = "(no material)";
+
             if (!shapes[s].mesh.material_ids.empty() && !materials.empty()) {
 
                 int materialId = shapes[s].mesh.material_ids[0];
 
                 if (materialId >= 0 && materialId < (int)materials.size()) {
 
+                    materialName = materials[materialId].name.empty() ? "(unnamed material)" : materials[materialId].name;
+
                     materialDiffuse = glm::vec3(
                         materials[materialId].diffuse[0],
                         materials[materialId].diffuse[1],
@@ -99,28 +196,36 @@ namespace gps {
                     // ambient texture (optional)
                     std::string ambientTexturePath = materials[materialId].ambient_texname;
                     if (!ambientTexturePath.empty()) {
-                        textures.push_back(LoadTexture(basePath + ambientTexturePath, "ambientTexture"));
+                        textures.push_back(LoadTexture(basePath + ambientTexturePath, "ambientTexture", materialName));
                     }
 
                     // diffuse texture (optional)
                     std::string diffuseTexturePath = materials[materialId].diffuse_texname;
                     if (!diffuseTexturePath.empty()) {
-                        textures.push_back(LoadTexture(basePath + diffuseTexturePath, "diffuseTexture"));
+                        textures.push_back(LoadTexture(basePath + diffuseTexturePath, "diffuseTexture", materialName));
                     }
 
                     // specular texture (optional) 
                     std::string specularTexturePath = materials[materialId].specular_texname;
                     if (!specularTexturePath.empty()) {
-                        textures.push_back(LoadTexture(basePath + specularTexturePath, "specularTexture"));
+                        textures.push_back(LoadTexture(basePath + specularTexturePath, "specularTexture", materialName));
                     }
                 }
             }
 
-            meshes.push_back(gps::Mesh(vertices, indices, textures, materialDiffuse));
+            meshes.push_back(gps::Mesh(std::move(geometry[s].vertices), std::move(geometry[s].indices), textures, materialDiffuse));
+            meshBounds.push_back(geometry[s].bounds);
+
+            // the mesh keeps its vertices and indices after upload (colliders, triangle counts)
+            gps::Buffers buffers = meshes.back().getBuffers();
+            long long vertexBytes = (long long)(meshes.back().vertices.size() * sizeof(gps::Vertex));
+            long long indexBytes = (long long)(meshes.back().indices.size() * sizeof(GLuint));
+            ResourceTracker::add(ResourceTracker::Kind::Buffer, buffers.VBO, fileName, materialName, vertexBytes, vertexBytes);
+            ResourceTracker::add(ResourceTracker::Kind::Buffer, buffers.EBO, fileName, materialName, indexBytes, indexBytes);
         }
     }
 
-    gps::Texture Model3D::LoadTexture(std::string path, std::string type) {
+    gps::Texture Model3D::LoadTexture(std::string path, std::string type, const std::string& material) {
 
         for (int i = 0; i < loadedTextures.size(); i++) {
             if (loadedTextures[i].path == path) {
@@ -129,7 +234,7 @@ namespace gps {
         }
 
         gps::Texture currentTexture;
-        currentTexture.id = ReadTextureFromFile(path.c_str());
+        currentTexture.id = ReadTextureFromFile(path.c_str(), material, type != "specularTexture");
         currentTexture.type = std::string(type);
         currentTexture.path = path;
 
@@ -137,11 +242,26 @@ namespace gps {
         return currentTexture;
     }
 
-    GLuint Model3D::ReadTextureFromFile(const char* file_name) {
+    GLuint Model3D::ReadTextureFromFile(const char* file_name, const std::string& material, bool color) {
+        PROFILE_ZONE("Model3D::ReadTextureFromFile");
+
+        // blocks from the cache skip decoding and compressing altogether
+        std::string cacheFile = TextureCache::pathFor(file_name);
+        std::string cacheKey = TextureCache::keyFor(file_name, color);
+        bool useCache = compressTextures && TextureCache::enabled() && !cacheKey.empty();
+        if (useCache) {
+            TextureCompressor::Image cached;
+            if (TextureCache::load(cacheFile, cacheKey, cached) && TextureCompressor::supported(cached.format, cached.srgb))
+                return UploadCompressedTexture(cached, material);
+        }
 
         int x, y, n;
         int force_channels = 4;
-        unsigned char* image_data = stbi_load(file_name, &x, &y, &n, force_channels);
+        unsigned char* image_data;
+        {
+            PROFILE_ZONE("stbi_load");
+            image_data = stbi_load(file_name, &x, &y, &n, force_channels);
+        }
 
         if (!image_data) {
             fprintf(stderr, "ERROR: could not load %s\n", file_name);
@@ -171,12 +291,32 @@ namespace gps {
             }
         }
 
+        if (compressTextures) {
+            TextureCompressor::Format format = TextureCompressor::choose(image_data, x, y, color);
+            // without S3TC (some macOS drivers) the texture stays uncompressed
+            if (TextureCompressor::supported(format, color)) {
+                TextureCompressor::Image compressed = TextureCompressor::compress(image_data, x, y, format, color, jobs);
+                stbi_image_free(image_data);
+                if (useCache)
+                    TextureCache::save(cacheFile, cacheKey, compressed);
+                return UploadCompressedTexture(compressed, material);
+            }
+        }
+
         GLuint textureID;
         glGenTextures(1, &textureID);
         glBindTexture(GL_TEXTURE_2D, textureID);
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // colour is GL_SRGB and sampled as linear light, so its mips are filtered that way too;
+        // masks (specular) hold linear values, as in the compressed path
+        GLenum internalFormat = color ? GL_SRGB : GL_RGBA8;
+        std::vector<MipGenerator::Level> mips = MipGenerator::generate(image_data, x, y, color, jobs);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
+        for (size_t level = 0; level < mips.size(); level++) {
+            glTexImage2D(GL_TEXTURE_2D, (GLint)level + 1, internalFormat, mips[level].width, mips[level].height, 0,
+                GL_RGBA, GL_UNSIGNED_BYTE, mips[level].rgba.data());
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)mips.size());
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -186,12 +326,50 @@ namespace gps {
         glBindTexture(GL_TEXTURE_2D, 0);
         stbi_image_free(image_data);
 
+        // drivers store GL_SRGB with a padding byte, as 4 bytes a texel like RGBA8
+        ResourceTracker::add(ResourceTracker::Kind::Texture, textureID, fileName, material,
+            ResourceTracker::textureBytes(x, y, 4, true));
+
+        return textureID;
+    }
+
+    GLuint Model3D::UploadCompressedTexture(const TextureCompressor::Image& image, const std::string& material) {
+        PROFILE_ZONE("Model3D::UploadCompressedTexture");
+        GLenum internalFormat = TextureCompressor::glInternalFormat(image.format, image.srgb);
+
+        GLuint textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+
+        for (size_t level = 0; level < image.levels.size(); level++) {
+            const TextureCompressor::Level& l = image.levels[level];
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, internalFormat, l.width, l.height, 0,
+                (GLsizei)l.data.size(), l.data.data());
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // grey masks are stored in red only; sample them as grey like before
+        if (image.format == TextureCompressor::Format::BC4) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        ResourceTracker::add(ResourceTracker::Kind::Texture, textureID, fileName, material, image.bytes());
         return textureID;
     }
 
     Model3D::~Model3D() {
 
         for (size_t i = 0; i < loadedTextures.size(); i++) {
+            ResourceTracker::remove(ResourceTracker::Kind::Texture, loadedTextures.at(i).id);
             glDeleteTextures(1, &loadedTextures.at(i).id);
         }
 
@@ -199,6 +377,8 @@ namespace gps {
             GLuint VBO = meshes.at(i).getBuffers().VBO;
             GLuint EBO = meshes.at(i).getBuffers().EBO;
             GLuint VAO = meshes.at(i).getBuffers().VAO;
+            ResourceTracker::remove(ResourceTracker::Kind::Buffer, VBO);
+            ResourceTracker::remove(ResourceTracker::Kind::Buffer, EBO);
             glDeleteBuffers(1, &VBO);
             glDeleteBuffers(1, &EBO);
             glDeleteVertexArrays(1, &VAO);
@@ -2,6 +2,9 @@
 #define Model3D_hpp
 
 #include "Mesh.hpp"
+#include "Collision.hpp"
+#include "JobSystem.hpp"
+#include "TextureCompressor.hpp"
 
 #include "tiny_obj_loader.h"
 #include "stb_image.h"
@@ -12,6 +15,13 @@
 
 namespace gps {
 
+    // meshes submitted and rejected by Model3D::Draw since the last reset (render thread)
+    struct DrawStats {
+        int meshesDrawn = 0;
+        int meshesCulled = 0;
+        long long triangles = 0;
+    };
+
     class Model3D {
 
     public:
@@ -23,17 +33,45 @@ namespace gps {
 
 		void Draw(gps::Shader shaderProgram);
 
+		// draws only the meshes whose bounds intersect the frustum of mvp
+		void Draw(gps::Shader shaderProgram, const glm::mat4& mvp);
+
+		// used to process OBJ shapes and cull meshes in parallel (optional)
+		static void setJobSystem(gps::JobSystem* jobSystem) { jobs = jobSystem; }
+
+		// BCn textures with their mip chains (default), or RGBA8
+		static void setTextureCompression(bool enabled) { compressTextures = enabled; }
+
+		static const DrawStats& drawStats() { return stats; }
+		static void resetDrawStats() { stats = DrawStats(); }
+
+		// loaded geometry (model space), used to derive colliders
+		const std::vector<gps::Mesh>& getMeshes() const { return meshes; }
+		const std::string& getFileName() const { return fileName; }
+
     private:
         std::vector<gps::Mesh> meshes;
+        std::string fileName;
+        // model-space bounds per mesh and the last culling result
+        std::vector<gps::AABB> meshBounds;
+        std::vector<unsigned char> meshVisible;
+
+        static gps::JobSystem* jobs;
+        static DrawStats stats;
+        static bool compressTextures;
 		// Associated textures
         std::vector<gps::Texture> loadedTextures;
 
 		void ReadOBJ(std::string fileName, std::string basePath);
 
-		gps::Texture LoadTexture(std::string path, std::string type);
+		// material only labels the memory it takes (ResourceTracker)
+		gps::Texture LoadTexture(std::string path, std::string type, const std::string& material);
+
+		// Reads the pixel data from an image file and loads it into the video memory;
+		// color textures are sRGB, the others (masks) are kept linear when compressed
+		GLuint ReadTextureFromFile(const char* file_name, const std::string& material, bool color);
 
-		// Reads the pixel data from an image file and loads it into the video memory
-		GLuint ReadTextureFromFile(const char* file_name);
+		GLuint UploadCompressedTexture(const gps::TextureCompressor::Image& image, const std::string& material);
     };
 }
 
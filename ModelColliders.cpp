@@ -0,0 +1,226 @@
+#include "ModelColliders.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace gps {
+
+    static const uint32_t CACHE_MAGIC = 0x4c4f4347u; // "GCOL"
+    static const uint32_t CACHE_VERSION = 3u;
+
+    static uint32_t floatBits(float f) {
+        uint32_t u;
+        std::memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    static void extend(AABB& b, const glm::vec3& p) {
+        b.min = glm::min(b.min, p);
+        b.max = glm::max(b.max, p);
+    }
+
+    static AABB emptyBox() {
+        return AABB{ glm::vec3(1e30f), glm::vec3(-1e30f) };
+    }
+
+    // a box plus how much of its surface faces up
+    struct Piece {
+        AABB box = emptyBox();
+        float area = 0.0f;
+        float upArea = 0.0f;
+
+        void add(const Triangle& t, float walkableSlope) {
+            extend(box, t.a);
+            extend(box, t.b);
+            extend(box, t.c);
+            glm::vec3 n = glm::cross(t.b - t.a, t.c - t.a);
+            float a = glm::length(n);
+            area += a;
+            if (a > 0.0f && n.y / a > walkableSlope)
+                upArea += a;
+        }
+    };
+
+    static void addPiece(const Piece& piece, const ColliderSettings& settings, std::vector<AABB>& out) {
+        const AABB& b = piece.box;
+        if (b.min.x > b.max.x) return; // empty cell
+        if (b.max.y < settings.minTop) return;
+        if (b.min.y > settings.maxBottom) return;
+        if (b.max.x - b.min.x < settings.minSize && b.max.z - b.min.z < settings.minSize) return;
+        // planks, steps and floors are walked on (ground BVH), not pushed against
+        if (piece.area > 0.0f && piece.upArea >= settings.walkableArea * piece.area) return;
+        out.push_back(b);
+    }
+
+    void ModelColliders::fromTriangles(const std::vector<Triangle>& tris, const ColliderSettings& settings, std::vector<AABB>& out) {
+        Piece whole;
+        for (const Triangle& t : tris)
+            whole.add(t, settings.walkableSlope);
+
+        glm::vec3 extent = whole.box.max - whole.box.min;
+        if (tris.empty() || std::max(extent.x, extent.z) <= settings.splitSize) {
+            addPiece(whole, settings, out);
+            return;
+        }
+
+        // large mesh: bucket triangles by centroid into splitSize cells
+        int nx = std::max(1, (int)std::ceil(extent.x / settings.splitSize));
+        int nz = std::max(1, (int)std::ceil(extent.z / settings.splitSize));
+        std::vector<Piece> cells((size_t)nx * nz);
+
+        for (const Triangle& t : tris) {
+            glm::vec3 centroid = (t.a + t.b + t.c) / 3.0f;
+            int cx = std::min(std::max((int)((centroid.x - whole.box.min.x) / settings.splitSize), 0), nx - 1);
+            int cz = std::min(std::max((int)((centroid.z - whole.box.min.z) / settings.splitSize), 0), nz - 1);
+            cells[(size_t)cz * nx + cx].add(t, settings.walkableSlope);
+        }
+
+        for (const Piece& cell : cells)
+            addPiece(cell, settings, out);
+    }
+
+    void ModelColliders::generate(const Model3D& model, const glm::mat4& modelMatrix,
+        const ColliderSettings& settings, std::vector<AABB>& out) {
+
+        std::vector<glm::vec3> world;
+        std::vector<Triangle> tris;
+
+        for (const Mesh& mesh : model.getMeshes()) {
+            if (mesh.vertices.empty()) continue;
+
+            world.resize(mesh.vertices.size());
+            for (size_t i = 0; i < mesh.vertices.size(); i++)
+                world[i] = glm::vec3(modelMatrix * glm::vec4(mesh.vertices[i].Position, 1.0f));
+
+            tris.clear();
+            for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+                tris.push_back(Triangle{ world[mesh.indices[t]], world[mesh.indices[t + 1]], world[mesh.indices[t + 2]] });
+            fromTriangles(tris, settings, out);
+        }
+    }
+
+    void ModelColliders::triangles(const Model3D& model, const glm::mat4& modelMatrix, std::vector<Triangle>& out) {
+        for (const Mesh& mesh : model.getMeshes()) {
+            for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+                Triangle tri;
+                tri.a = glm::vec3(modelMatrix * glm::vec4(mesh.vertices[mesh.indices[t + 0]].Position, 1.0f));
+                tri.b = glm::vec3(modelMatrix * glm::vec4(mesh.vertices[mesh.indices[t + 1]].Position, 1.0f));
+                tri.c = glm::vec3(modelMatrix * glm::vec4(mesh.vertices[mesh.indices[t + 2]].Position, 1.0f));
+                out.push_back(tri);
+            }
+        }
+    }
+
+    bool ModelColliders::loadCache(const std::string& path, const std::vector<uint32_t>& key, std::vector<AABB>& out) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        uint64_t fileSize = (uint64_t)in.tellg();
+        in.seekg(0);
+
+        uint32_t header[3] = {};
+        in.read((char*)header, sizeof(header));
+        if (!in || header[0] != CACHE_MAGIC || header[1] != CACHE_VERSION || header[2] != key.size())
+            return false;
+
+        std::vector<uint32_t> storedKey(key.size());
+        in.read((char*)storedKey.data(), storedKey.size() * sizeof(uint32_t));
+        if (!in || storedKey != key) return false;
+
+        uint32_t count = 0;
+        in.read((char*)&count, sizeof(count));
+        if (!in) return false;
+
+        // a truncated or corrupt file must not size the allocation
+        uint64_t boxBytes = 6 * sizeof(float);
+        if (fileSize - (uint64_t)in.tellg() != count * boxBytes) {
+            std::cout << "WARNING: collider cache " << path << " is truncated, rebuilding" << std::endl;
+            return false;
+        }
+
+        std::vector<AABB> boxes(count);
+        for (uint32_t i = 0; i < count; i++) {
+            float v[6];
+            in.read((char*)v, sizeof(v));
+            boxes[i] = AABB{ glm::vec3(v[0], v[1], v[2]), glm::vec3(v[3], v[4], v[5]) };
+        }
+        if (!in) return false;
+
+        out.insert(out.end(), boxes.begin(), boxes.end());
+        return true;
+    }
+
+    void ModelColliders::saveCache(const std::string& path, const std::vector<uint32_t>& key, const std::vector<AABB>& boxes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cout << "WARNING: could not write collider cache " << path << std::endl;
+            return;
+        }
+
+        uint32_t header[3] = { CACHE_MAGIC, CACHE_VERSION, (uint32_t)key.size() };
+        file.write((const char*)header, sizeof(header));
+        file.write((const char*)key.data(), key.size() * sizeof(uint32_t));
+
+        uint32_t count = (uint32_t)boxes.size();
+        file.write((const char*)&count, sizeof(count));
+        for (const AABB& b : boxes) {
+            float v[6] = { b.min.x, b.min.y, b.min.z, b.max.x, b.max.y, b.max.z };
+            file.write((const char*)v, sizeof(v));
+        }
+    }
+
+    void ModelColliders::build(const Model3D& model, const glm::mat4& modelMatrix,
+        const ColliderSettings& settings, std::vector<AABB>& out) {
+
+        const std::string& objPath = model.getFileName();
+
+        // the cache is only valid for the same obj (size and modification time), placement and filter
+        uint64_t objSize = 0, objTime = 0;
+        struct stat info;
+        if (stat(objPath.c_str(), &info) == 0) {
+            objSize = (uint64_t)info.st_size;
+            objTime = (uint64_t)info.st_mtime;
+        }
+
+        uint64_t vertexCount = 0;
+        for (const Mesh& mesh : model.getMeshes())
+            vertexCount += mesh.vertices.size();
+
+        std::vector<uint32_t> key;
+        key.push_back((uint32_t)objSize);
+        key.push_back((uint32_t)(objSize >> 32));
+        key.push_back((uint32_t)objTime);
+        key.push_back((uint32_t)(objTime >> 32));
+        key.push_back((uint32_t)vertexCount);
+        key.push_back((uint32_t)model.getMeshes().size());
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+                key.push_back(floatBits(modelMatrix[c][r]));
+        key.push_back(floatBits(settings.minTop));
+        key.push_back(floatBits(settings.maxBottom));
+        key.push_back(floatBits(settings.minSize));
+        key.push_back(floatBits(settings.splitSize));
+        key.push_back(floatBits(settings.walkableSlope));
+        key.push_back(floatBits(settings.walkableArea));
+
+        std::string cachePath = objPath + ".colliders";
+        size_t first = out.size();
+
+        if (loadCache(cachePath, key, out)) {
+            std::cout << "Colliders : " << out.size() - first << " (cached, " << cachePath << ")" << std::endl;
+            return;
+        }
+
+        std::vector<AABB> boxes;
+        generate(model, modelMatrix, settings, boxes);
+        saveCache(cachePath, key, boxes);
+        out.insert(out.end(), boxes.begin(), boxes.end());
+
+        std::cout << "Colliders : " << boxes.size() << " generated from "
+            << model.getMeshes().size() << " meshes" << std::endl;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef ModelColliders_hpp
+#define ModelColliders_hpp
+
+#include "Model3D.hpp"
+#include "Collision.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace gps {
+
+    // which parts of a model become colliders (world units, after the model matrix)
+    struct ColliderSettings {
+        // pieces whose top is below this are walkable ground clutter
+        float minTop = 0.5f;
+        // pieces that start above this are overhead (canopies, roofs) and are skipped
+        float maxBottom = 2.2f;
+        // pieces thinner than this on both horizontal axes are ignored
+        float minSize = 0.05f;
+        // shapes wider than this are split in cells of this size so that
+        // terrain and long walls don't turn into one huge box
+        float splitSize = 2.0f;
+        // triangles whose normal has at least this y face up
+        float walkableSlope = 0.7f;
+        // pieces with at least this share of up-facing area (bridge planks, steps,
+        // floors) are ground: the player steps onto them instead of being pushed off
+        float walkableArea = 0.35f;
+    };
+
+    // derives AABB colliders from the meshes of a loaded model: one box per mesh,
+    // or one box per splitSize cell of its triangles for large meshes; walkable
+    // pieces are left to the ground BVH.
+    // Results are cached next to the obj in "<obj>.colliders" and reused while the
+    // obj (size and modification time), the model matrix and the settings stay the same.
+    class ModelColliders {
+
+    public:
+        static void build(const gps::Model3D& model, const glm::mat4& modelMatrix,
+            const ColliderSettings& settings, std::vector<gps::AABB>& out);
+
+        // the pieces of one mesh given as world-space triangles
+        static void fromTriangles(const std::vector<gps::Triangle>& tris, const ColliderSettings& settings,
+            std::vector<gps::AABB>& out);
+
+        // every triangle of the model in world space (for the ground BVH)
+        static void triangles(const gps::Model3D& model, const glm::mat4& modelMatrix, std::vector<gps::Triangle>& out);
+
+    private:
+        static void generate(const gps::Model3D& model, const glm::mat4& modelMatrix,
+            const ColliderSettings& settings, std::vector<gps::AABB>& out);
+        static bool loadCache(const std::string& path, const std::vector<uint32_t>& key, std::vector<gps::AABB>& out);
+        static void saveCache(const std::string& path, const std::vector<uint32_t>& key, const std::vector<gps::AABB>& boxes);
+    };
+}
+
+#endif /* ModelColliders_hpp */
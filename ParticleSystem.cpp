@@ -0,0 +1,601 @@
+#include "ParticleSystem.hpp"
+#include "Profiler.hpp"
+#include "ResourceTracker.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "GLStatsHooks.hpp"
+
+namespace gps {
+
+    // petal behaviour (matches the look of the old procedural sakura.vert)
+    static const float GRAVITY = 0.55f;
+    static const float AIR_DRAG = 1.8f;
+    static const float CANOPY_BASE = 2.4f;
+    static const float CANOPY_HEIGHT = 0.6f;
+    static const float CANOPY_RADIUS_MIN = 1.5f;
+    static const float CANOPY_RADIUS_MAX = 4.8f;
+    static const float WIND_X = 1.5f;
+    static const float WIND_Z = 1.2f;
+    static const float FLUTTER = 0.6f;
+    static const float LIFETIME_MIN = 20.0f;
+    static const float LIFETIME_MAX = 32.0f;
+
+    static const float PI = 3.14159265f;
+    static const float TWO_PI = 6.28318531f;
+
+    // ---------------------------------------------------------------------
+    // SIMD helpers: 8 lanes with AVX, 4 with SSE2, plain floats otherwise
+    // ---------------------------------------------------------------------
+#if defined(__AVX__)
+    typedef __m256 simd;
+    static const int LANES = 8;
+    static inline simd vload(const float* p) { return _mm256_loadu_ps(p); }
+    static inline void vstore(float* p, simd a) { _mm256_storeu_ps(p, a); }
+    static inline simd vset(float a) { return _mm256_set1_ps(a); }
+    static inline simd vadd(simd a, simd b) { return _mm256_add_ps(a, b); }
+    static inline simd vsub(simd a, simd b) { return _mm256_sub_ps(a, b); }
+    static inline simd vmul(simd a, simd b) { return _mm256_mul_ps(a, b); }
+    static inline simd vmax(simd a, simd b) { return _mm256_max_ps(a, b); }
+    static inline simd vand(simd a, simd b) { return _mm256_and_ps(a, b); }
+    static inline simd vlt(simd a, simd b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static inline simd vgt(simd a, simd b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static inline simd vselect(simd a, simd b, simd mask) { return _mm256_blendv_ps(a, b, mask); }
+    static inline simd vround(simd a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static inline simd vabs(simd a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static inline bool vany(simd mask) { return _mm256_movemask_ps(mask) != 0; }
+#define GPS_PARTICLE_SIMD 1
+#elif defined(__SSE2__) || defined(_M_X64)
+    typedef __m128 simd;
+    static const int LANES = 4;
+    static inline simd vload(const float* p) { return _mm_loadu_ps(p); }
+    static inline void vstore(float* p, simd a) { _mm_storeu_ps(p, a); }
+    static inline simd vset(float a) { return _mm_set1_ps(a); }
+    static inline simd vadd(simd a, simd b) { return _mm_add_ps(a, b); }
+    static inline simd vsub(simd a, simd b) { return _mm_sub_ps(a, b); }
+    static inline simd vmul(simd a, simd b) { return _mm_mul_ps(a, b); }
+    static inline simd vmax(simd a, simd b) { return _mm_max_ps(a, b); }
+    static inline simd vand(simd a, simd b) { return _mm_and_ps(a, b); }
+    static inline simd vlt(simd a, simd b) { return _mm_cmplt_ps(a, b); }
+    static inline simd vgt(simd a, simd b) { return _mm_cmpgt_ps(a, b); }
+    static inline simd vselect(simd a, simd b, simd mask) { return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a)); }
+    static inline simd vround(simd a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+    static inline simd vabs(simd a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    static inline bool vany(simd mask) { return _mm_movemask_ps(mask) != 0; }
+#define GPS_PARTICLE_SIMD 1
+#endif
+
+    // parabolic sine approximation, error < 0.001 on any input range
+    static inline float fastSin(float x) {
+        x -= TWO_PI * std::nearbyint(x * (1.0f / TWO_PI));
+        float y = (4.0f / PI) * x - (4.0f / (PI * PI)) * x * std::fabs(x);
+        return 0.225f * (y * std::fabs(y) - y) + y;
+    }
+
+#if defined(GPS_PARTICLE_SIMD)
+    static inline simd fastSin(simd x) {
+        x = vsub(x, vmul(vset(TWO_PI), vround(vmul(x, vset(1.0f / TWO_PI)))));
+        simd y = vsub(vmul(vset(4.0f / PI), x), vmul(vmul(vset(4.0f / (PI * PI)), x), vabs(x)));
+        return vadd(vmul(vset(0.225f), vsub(vmul(y, vabs(y)), y)), y);
+    }
+#endif
+
+    ParticleSystem::~ParticleSystem() {
+        if (pending) finishUpdate();
+
+        for (int i = 0; i < BUFFER_REGIONS; i++) {
+            if (fences[i]) glDeleteSync(fences[i]);
+        }
+        ResourceTracker::remove(ResourceTracker::Kind::Buffer, vbo);
+        ResourceTracker::remove(ResourceTracker::Kind::Buffer, ibo);
+        if (vbo) glDeleteBuffers(1, &vbo);
+        if (ibo) glDeleteBuffers(1, &ibo);
+        if (vao) glDeleteVertexArrays(1, &vao);
+    }
+
+    float ParticleSystem::random01(uint32_t& state) {
+        // xorshift32, deterministic for a given seed
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state & 0xFFFFFF) / float(0x1000000);
+    }
+
+    void ParticleSystem::init(int maxParticles, unsigned int seed) {
+        particleCount = maxParticles;
+        paddedCount = (maxParticles + 7) & ~7;
+
+        std::vector<float>* arrays[] = { &px, &py, &pz, &vx, &vy, &vz, &life, &lifeRate, &phase };
+        for (auto* a : arrays) a->assign(paddedCount, 0.0f);
+
+        output[0].assign(particleCount, ParticleVertex{});
+        output[1].assign(particleCount, ParticleVertex{});
+        front = 0;
+
+        blockRng.resize(blockCount());
+        uint32_t mix = seed ? seed : 1u;
+        for (auto& r : blockRng) {
+            random01(mix);
+            r = mix;
+        }
+    }
+
+    void ParticleSystem::addEmitter(glm::vec3 treePosition) {
+        emitters.push_back(treePosition);
+
+        // (re)distribute all petals once the first tree is known
+        if (emitters.size() == 1) {
+            for (int b = 0; b < blockCount(); b++) {
+                int end = std::min((b + 1) * BLOCK_SIZE, particleCount);
+                for (int i = b * BLOCK_SIZE; i < end; i++) respawn(i, true, blockRng[b]);
+            }
+            writeVertices(0, particleCount, output[front].data());
+        }
+    }
+
+    void ParticleSystem::setColliders(const std::vector<gps::AABB>& boxes) {
+        colliders = boxes;
+    }
+
+    void ParticleSystem::setGroundHeight(float y) {
+        groundY = y;
+    }
+
+    void ParticleSystem::respawn(int i, bool randomAge, uint32_t& rng) {
+        const glm::vec3& tree = emitters[(size_t)(random01(rng) * emitters.size()) % emitters.size()];
+
+        float angle = random01(rng) * TWO_PI;
+        float radius = CANOPY_RADIUS_MIN + std::sqrt(random01(rng)) * (CANOPY_RADIUS_MAX - CANOPY_RADIUS_MIN);
+
+        px[i] = tree.x + std::cos(angle) * radius;
+        py[i] = tree.y - CANOPY_BASE + random01(rng) * CANOPY_HEIGHT;
+        pz[i] = tree.z + std::sin(angle) * radius;
+
+        vx[i] = vy[i] = vz[i] = 0.0f;
+
+        lifeRate[i] = 1.0f / (LIFETIME_MIN + random01(rng) * (LIFETIME_MAX - LIFETIME_MIN));
+        life[i] = randomAge ? random01(rng) : 0.0f;
+        phase[i] = random01(rng) * TWO_PI;
+    }
+
+    void ParticleSystem::respawnDead(int begin, int end, uint32_t& rng) {
+        if (emitters.empty())
+            return;
+
+        end = std::min(end, particleCount);
+        for (int i = begin; i < end; i++) {
+            if (life[i] >= 1.0f) respawn(i, false, rng);
+        }
+    }
+
+    void ParticleSystem::simulateBlock(int block, float time, float dt) {
+        int begin = block * BLOCK_SIZE;
+        int end = std::min(begin + BLOCK_SIZE, paddedCount);
+
+        integrate(begin, end, time, dt);
+        collide(begin, end);
+        respawnDead(begin, end, blockRng[block]);
+
+        // write into the back buffer; the front one may be uploading meanwhile
+        writeVertices(begin, std::min(end, particleCount), output[front ^ 1].data());
+    }
+
+    void ParticleSystem::update(float time, float dt) {
+        if (pending) finishUpdate();
+
+        for (int b = 0; b < blockCount(); b++)
+            simulateBlock(b, time, dt);
+
+        front ^= 1;
+        sortValid = false;
+    }
+
+    void ParticleSystem::beginUpdate(gps::JobSystem& jobs, float time, float dt) {
+        if (pending) finishUpdate();
+
+        pending = true;
+        pendingJobs = &jobs;
+        for (int block = 0; block < blockCount(); block++) {
+            jobs.run([this, block, time, dt] {
+                PROFILE_ZONE("petal block");
+                simulateBlock(block, time, dt);
+            }, &updateJobs);
+        }
+    }
+
+    void ParticleSystem::finishUpdate() {
+        if (!pending)
+            return;
+
+        pendingJobs->wait(updateJobs);
+        pending = false;
+        pendingJobs = nullptr;
+        front ^= 1;
+        sortValid = false;
+    }
+
+    void ParticleSystem::sortByDepth(const glm::mat4& view, gps::JobSystem* jobs) {
+        sortKeys.resize(particleCount);
+        sortedIndices.resize(particleCount);
+
+        const ParticleVertex* v = vertices();
+        const int blocks = (particleCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        // distance along the view axis; larger distance sorts first (back to front)
+        auto keyBlock = [&](int b) {
+            int end = std::min(particleCount, (b + 1) * BLOCK_SIZE);
+            for (int i = b * BLOCK_SIZE; i < end; i++) {
+                float dist = -(view[0][2] * v[i].x + view[1][2] * v[i].y + view[2][2] * v[i].z + view[3][2]);
+                sortKeys[i] = ~RadixSort::floatKey(dist);
+                sortedIndices[i] = (uint32_t)i;
+            }
+        };
+
+        if (jobs && blocks > 1) {
+            jobs->parallelFor(0, blocks, 1, [&](int first, int last) {
+                for (int b = first; b < last; b++) keyBlock(b);
+            });
+        }
+        else {
+            for (int b = 0; b < blocks; b++) keyBlock(b);
+        }
+
+        sorter.sort(sortKeys, sortedIndices, jobs);
+        sortValid = true;
+    }
+
+    void ParticleSystem::integrate(int begin, int end, float time, float dt) {
+        // uniform wind for this step, per-petal flutter from its phase
+        const float windXs = std::sin(time * 0.6f) * WIND_X;
+        const float windZs = std::cos(time * 0.5f) * WIND_Z;
+#if defined(GPS_PARTICLE_SIMD)
+        const simd windX = vset(windXs);
+        const simd windZ = vset(windZs);
+        const simd flutterTimeX = vset(time * 7.0f);
+        const simd flutterTimeZ = vset(time * 6.0f + 0.5f * PI);
+        const simd flutter = vset(FLUTTER);
+        const simd drag = vset(AIR_DRAG * dt);
+        const simd gravity = vset(GRAVITY * dt);
+        const simd step = vset(dt);
+        const simd ground = vset(groundY);
+        const simd zero = vset(0.0f);
+
+        for (int i = begin; i < end; i += LANES) {
+            simd x = vload(&px[i]), y = vload(&py[i]), z = vload(&pz[i]);
+            simd u = vload(&vx[i]), v = vload(&vy[i]), w = vload(&vz[i]);
+            simd ph = vload(&phase[i]);
+
+            // only airborne petals feel wind and gravity
+            simd airborne = vgt(y, ground);
+
+            simd targetX = vadd(windX, vmul(flutter, fastSin(vadd(flutterTimeX, ph))));
+            simd targetZ = vadd(windZ, vmul(flutter, fastSin(vadd(flutterTimeZ, ph))));
+
+            u = vadd(u, vmul(drag, vsub(targetX, u)));
+            w = vadd(w, vmul(drag, vsub(targetZ, w)));
+            v = vsub(v, vadd(gravity, vmul(drag, v)));
+
+            u = vand(u, airborne);
+            v = vand(v, airborne);
+            w = vand(w, airborne);
+
+            x = vadd(x, vmul(u, step));
+            y = vadd(y, vmul(v, step));
+            z = vadd(z, vmul(w, step));
+
+            // settle on the ground
+            simd below = vlt(y, ground);
+            y = vmax(y, ground);
+            v = vselect(v, zero, below);
+
+            vstore(&px[i], x); vstore(&py[i], y); vstore(&pz[i], z);
+            vstore(&vx[i], u); vstore(&vy[i], v); vstore(&vz[i], w);
+            vstore(&life[i], vadd(vload(&life[i]), vmul(vload(&lifeRate[i]), step)));
+        }
+#else
+        const float drag = AIR_DRAG * dt;
+
+        for (int i = begin; i < end; i++) {
+            if (py[i] > groundY) {
+                float targetX = windXs + FLUTTER * fastSin(time * 7.0f + phase[i]);
+                float targetZ = windZs + FLUTTER * fastSin(time * 6.0f + 0.5f * PI + phase[i]);
+
+                vx[i] += drag * (targetX - vx[i]);
+                vz[i] += drag * (targetZ - vz[i]);
+                vy[i] -= GRAVITY * dt + drag * vy[i];
+            }
+            else {
+                vx[i] = vy[i] = vz[i] = 0.0f;
+            }
+
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            pz[i] += vz[i] * dt;
+
+            if (py[i] < groundY) {
+                py[i] = groundY;
+                vy[i] = 0.0f;
+            }
+
+            life[i] += lifeRate[i] * dt;
+        }
+#endif
+    }
+
+    void ParticleSystem::updateScalar(float time, float dt) {
+        if (pending) finishUpdate();
+
+        const float windX = std::sin(time * 0.6f) * WIND_X;
+        const float windZ = std::cos(time * 0.5f) * WIND_Z;
+        const float drag = AIR_DRAG * dt;
+
+        for (int i = 0; i < particleCount; i++) {
+            if (py[i] > groundY) {
+                float targetX = windX + FLUTTER * fastSin(time * 7.0f + phase[i]);
+                float targetZ = windZ + FLUTTER * fastSin(time * 6.0f + 0.5f * PI + phase[i]);
+
+                vx[i] += drag * (targetX - vx[i]);
+                vz[i] += drag * (targetZ - vz[i]);
+                vy[i] -= GRAVITY * dt + drag * vy[i];
+            }
+            else {
+                vx[i] = vy[i] = vz[i] = 0.0f;
+            }
+
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            pz[i] += vz[i] * dt;
+
+            if (py[i] < groundY) {
+                py[i] = groundY;
+                vy[i] = 0.0f;
+            }
+
+            life[i] += lifeRate[i] * dt;
+        }
+
+        for (const auto& b : colliders) {
+            for (int i = 0; i < particleCount; i++) {
+                if (px[i] > b.min.x && px[i] < b.max.x &&
+                    py[i] > b.min.y && py[i] < b.max.y &&
+                    pz[i] > b.min.z && pz[i] < b.max.z) {
+                    // rest on top of the box
+                    py[i] = b.max.y;
+                    vx[i] = vy[i] = vz[i] = 0.0f;
+                }
+            }
+        }
+
+        for (int b = 0; b < blockCount(); b++)
+            respawnDead(b * BLOCK_SIZE, (b + 1) * BLOCK_SIZE, blockRng[b]);
+
+        writeVertices(0, particleCount, output[front ^ 1].data());
+        front ^= 1;
+        sortValid = false;
+    }
+
+    void ParticleSystem::collide(int begin, int end) {
+#if defined(GPS_PARTICLE_SIMD)
+        const simd zero = vset(0.0f);
+
+        for (const auto& b : colliders) {
+            const simd minX = vset(b.min.x), minY = vset(b.min.y), minZ = vset(b.min.z);
+            const simd maxX = vset(b.max.x), maxY = vset(b.max.y), maxZ = vset(b.max.z);
+
+            for (int i = begin; i < end; i += LANES) {
+                simd x = vload(&px[i]), y = vload(&py[i]), z = vload(&pz[i]);
+
+                simd inside = vand(vand(vgt(x, minX), vlt(x, maxX)),
+                    vand(vand(vgt(y, minY), vlt(y, maxY)),
+                        vand(vgt(z, minZ), vlt(z, maxZ))));
+
+                if (!vany(inside))
+                    continue;
+
+                // rest on top of the box
+                vstore(&py[i], vselect(y, maxY, inside));
+                vstore(&vx[i], vselect(vload(&vx[i]), zero, inside));
+                vstore(&vy[i], vselect(vload(&vy[i]), zero, inside));
+                vstore(&vz[i], vselect(vload(&vz[i]), zero, inside));
+            }
+        }
+#else
+        for (const auto& b : colliders) {
+            for (int i = begin; i < end; i++) {
+                if (px[i] > b.min.x && px[i] < b.max.x &&
+                    py[i] > b.min.y && py[i] < b.max.y &&
+                    pz[i] > b.min.z && pz[i] < b.max.z) {
+                    py[i] = b.max.y;
+                    vx[i] = vy[i] = vz[i] = 0.0f;
+                }
+            }
+        }
+#endif
+    }
+
+    void ParticleSystem::writeVertices(int begin, int end, ParticleVertex* out) const {
+        for (int i = begin; i < end; i++) {
+            out[i].x = px[i];
+            out[i].y = py[i];
+            out[i].z = pz[i];
+            out[i].life = life[i];
+        }
+    }
+
+    void ParticleSystem::initBuffers() {
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+        GLsizeiptr regionBytes = (GLsizeiptr)particleCount * sizeof(ParticleVertex);
+
+#if not defined (__APPLE__)
+        if (GLEW_ARB_buffer_storage) {
+            // one persistently mapped buffer split in BUFFER_REGIONS, written round-robin
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, regionBytes * BUFFER_REGIONS, nullptr, flags);
+            mapped = (ParticleVertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, regionBytes * BUFFER_REGIONS, flags);
+            persistent = mapped != nullptr;
+        }
+#endif
+        if (!persistent) {
+            glBufferData(GL_ARRAY_BUFFER, regionBytes, nullptr, GL_STREAM_DRAW);
+        }
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)0);
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, life));
+
+        // back-to-front order when depth sorting is on
+        glGenBuffers(1, &ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)particleCount * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+
+        glBindVertexArray(0);
+
+        // the SoA state and both output arrays live next to the vertex buffer
+        long long cpuBytes = 9LL * paddedCount * sizeof(float) + 2LL * particleCount * sizeof(ParticleVertex);
+        ResourceTracker::add(ResourceTracker::Kind::Buffer, vbo, "petals", "CPU simulation",
+            (long long)regionBytes * (persistent ? BUFFER_REGIONS : 1), cpuBytes);
+        ResourceTracker::add(ResourceTracker::Kind::Buffer, ibo, "petals", "CPU simulation",
+            (long long)particleCount * sizeof(uint32_t));
+
+        std::cout << "Sakura particles: " << particleCount
+            << (persistent ? " (persistent mapped buffer)" : " (orphaned stream buffer)") << std::endl;
+    }
+
+    void ParticleSystem::upload() {
+        size_t bytes = (size_t)particleCount * sizeof(ParticleVertex);
+
+        if (persistent) {
+            region = (region + 1) % BUFFER_REGIONS;
+
+            // wait until the GPU is done with the draw that last read this region
+            if (fences[region]) {
+                glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+                glDeleteSync(fences[region]);
+                fences[region] = 0;
+            }
+
+            std::memcpy(mapped + (size_t)region * particleCount, vertices(), bytes);
+            drawFirst = region * particleCount;
+        }
+        else {
+            // orphan the storage so the driver does not stall on the previous frame
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            drawFirst = 0;
+        }
+
+        if (sortValid) {
+            // the element buffer binding is VAO state
+            size_t indexBytes = sortedIndices.size() * sizeof(uint32_t);
+            glBindVertexArray(vao);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, sortedIndices.data());
+            glBindVertexArray(0);
+        }
+    }
+
+    void ParticleSystem::draw() {
+        glBindVertexArray(vao);
+        if (sortValid)
+            glDrawElementsBaseVertex(GL_POINTS, particleCount, GL_UNSIGNED_INT, (void*)0, drawFirst);
+        else
+            glDrawArrays(GL_POINTS, drawFirst, particleCount);
+        glBindVertexArray(0);
+
+        if (persistent) {
+            fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
+
+    static void addBenchmarkScene(ParticleSystem& ps) {
+        ps.addEmitter(glm::vec3(15.55f, 7.8f, 3.64f));
+        ps.addEmitter(glm::vec3(-0.71f, 7.8f, 13.82f));
+        ps.addEmitter(glm::vec3(15.28f, 7.8f, 16.12f));
+        ps.setColliders({
+            AABB{ glm::vec3(15.35f, 0.75f, 7.0f), glm::vec3(16.10f, 3.8f, 16.2f) },
+            AABB{ glm::vec3(-3.3f, 0.6f, -2.8f), glm::vec3(7.8f, 1.9f, 7.2f) } });
+    }
+
+    void ParticleSystem::benchmark(int particleCount, int frames) {
+        ParticleSystem simd;
+        simd.init(particleCount);
+        addBenchmarkScene(simd);
+
+        ParticleSystem scalar;
+        scalar.init(particleCount);
+        addBenchmarkScene(scalar);
+
+        const float dt = 1.0f / 60.0f;
+        typedef std::chrono::steady_clock clock;
+
+        auto run = [&](ParticleSystem& ps, bool useSimd) {
+            auto start = clock::now();
+            for (int f = 0; f < frames; f++) {
+                if (useSimd) ps.update(f * dt, dt);
+                else ps.updateScalar(f * dt, dt);
+            }
+            double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            return (double)particleCount * frames / ms;
+        };
+
+        double simdRate = run(simd, true);
+        double scalarRate = run(scalar, false);
+
+        std::cout << "Particle benchmark: " << particleCount << " petals, " << frames << " frames" << std::endl;
+#if defined(GPS_PARTICLE_SIMD)
+        std::cout << "  SIMD (" << LANES << " lanes): " << simdRate << " particles/ms per core" << std::endl;
+#else
+        std::cout << "  SIMD unavailable, scalar path: " << simdRate << " particles/ms per core" << std::endl;
+#endif
+        std::cout << "  scalar:          " << scalarRate << " particles/ms per core" << std::endl;
+    }
+
+    void ParticleSystem::benchmarkThreads(int particleCount, int frames, int maxThreads) {
+        const float dt = 1.0f / 60.0f;
+        typedef std::chrono::steady_clock clock;
+
+        std::cout << "Particle thread scaling: " << particleCount << " petals, " << frames << " frames, "
+            << BLOCK_SIZE << " petals per block" << std::endl;
+
+        double singleRate = 0.0;
+        for (int threads = 1; threads <= maxThreads; threads++) {
+            ParticleSystem ps;
+            ps.init(particleCount);
+            addBenchmarkScene(ps);
+
+            JobSystem jobs;
+            jobs.start(threads - 1);
+
+            auto start = clock::now();
+            for (int f = 0; f < frames; f++) {
+                ps.beginUpdate(jobs, f * dt, dt);
+                ps.finishUpdate();
+            }
+            double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            double rate = (double)particleCount * frames / ms;
+            if (threads == 1) singleRate = rate;
+
+            std::cout << "  " << threads << " thread(s): " << rate << " particles/ms, "
+                << ms / frames << " ms/frame, speedup " << rate / singleRate << "x" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef ParticleSystem_hpp
+#define ParticleSystem_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "Collision.hpp"
+#include "JobSystem.hpp"
+#include "RadixSort.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace gps {
+
+    // one petal as streamed to the GPU (petal.vert)
+    struct ParticleVertex {
+        float x, y, z;
+        float life;
+    };
+
+    // CPU sakura petal simulation; particle state is kept as separate
+    // arrays (SoA) so the integration runs 4/8 petals per SSE/AVX instruction.
+    // Petals are split in fixed-size blocks that run as jobs on the JobSystem;
+    // results go to a double-buffered vertex array.
+    class ParticleSystem {
+
+    public:
+        ~ParticleSystem();
+
+        void init(int maxParticles, unsigned int seed = 1234u);
+        void addEmitter(glm::vec3 treePosition);
+        void setColliders(const std::vector<gps::AABB>& boxes);
+        void setGroundHeight(float y);
+
+        // petals per job, a multiple of 8 so blocks never split a SIMD batch
+        static const int BLOCK_SIZE = 4096;
+
+        // advances every petal by dt on the calling thread; time drives the global wind
+        void update(float time, float dt);
+        // same integration without SIMD, used as reference by the benchmark
+        void updateScalar(float time, float dt);
+
+        // starts simulating the next frame as jobs and returns immediately;
+        // the current vertices stay valid for upload()/draw() until finishUpdate()
+        void beginUpdate(gps::JobSystem& jobs, float time, float dt);
+        // waits for beginUpdate and makes its result the current frame
+        void finishUpdate();
+        bool updatePending() const { return pending; }
+
+        // latest finished frame, count() vertices
+        const ParticleVertex* vertices() const { return output[front].data(); }
+        int count() const { return particleCount; }
+
+        // orders the current frame back to front for alpha blending (radix sort on view depth);
+        // valid until the next update, upload()/draw() then use the sorted index buffer
+        void sortByDepth(const glm::mat4& view, gps::JobSystem* jobs);
+
+        // GL streaming buffer (persistently mapped when GL_ARB_buffer_storage is available)
+        void initBuffers();
+        void upload();
+        void draw();
+        // first vertex of the region draw() reads; gl_VertexID minus this is the petal index
+        int drawBase() const { return drawFirst; }
+
+        // prints particles/ms for the SIMD and scalar paths on one core
+        static void benchmark(int particleCount, int frames);
+        // prints particles/ms and speedup for 1..maxThreads threads
+        static void benchmarkThreads(int particleCount, int frames, int maxThreads);
+
+    private:
+        int particleCount = 0;
+        int paddedCount = 0;
+
+        // SoA particle state, padded to a multiple of 8
+        std::vector<float> px, py, pz;
+        std::vector<float> vx, vy, vz;
+        std::vector<float> life, lifeRate, phase;
+
+        // double-buffered simulation output
+        std::vector<ParticleVertex> output[2];
+        int front = 0;
+        bool pending = false;
+        gps::JobSystem* pendingJobs = nullptr;
+        gps::JobCounter updateJobs;
+
+        std::vector<glm::vec3> emitters;
+        std::vector<gps::AABB> colliders;
+        float groundY = 0.0f;
+
+        // one random stream per block so blocks can respawn petals concurrently
+        std::vector<uint32_t> blockRng;
+
+        // depth sorting
+        gps::RadixSort sorter;
+        std::vector<uint32_t> sortKeys;
+        std::vector<uint32_t> sortedIndices;
+        bool sortValid = false;
+
+        // streaming
+        static const int BUFFER_REGIONS = 3;
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint ibo = 0;
+        bool persistent = false;
+        ParticleVertex* mapped = nullptr;
+        GLsync fences[BUFFER_REGIONS] = {};
+        int region = 0;
+        int drawFirst = 0;
+
+        int blockCount() const { return (paddedCount + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+
+        static float random01(uint32_t& state);
+        void respawn(int i, bool randomAge, uint32_t& rng);
+        void respawnDead(int begin, int end, uint32_t& rng);
+        void integrate(int begin, int end, float time, float dt);
+        void collide(int begin, int end);
+        void writeVertices(int begin, int end, ParticleVertex* out) const;
+        void simulateBlock(int block, float time, float dt);
+    };
+}
+
+#endif /* ParticleSystem_hpp */
@@ -0,0 +1,188 @@
+#include "Profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gps {
+
+    struct ZoneRecord {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    // one writer (the owning thread); read only while the rings are closed
+    struct ThreadBuffer {
+        static const size_t CAPACITY = 1 << 16;
+
+        std::vector<ZoneRecord> records;
+        std::atomic<uint64_t> written{ 0 };
+        std::atomic<bool> writing{ false };
+        int id = 0;
+        std::string name;
+    };
+
+    static std::atomic<bool> captureActive{ false };
+    static uint64_t captureStart = 0;
+    static uint64_t captureEnd = 0;
+    // set by endCapture: zones still open on other threads when the capture ends
+    // are dropped instead of writing a ring while the trace is serialized
+    static std::atomic<bool> ringsClosed{ false };
+
+    static std::mutex& registryMutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    // buffers outlive their threads so a trace can still be written afterwards
+    static std::vector<std::unique_ptr<ThreadBuffer>>& registry() {
+        static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        return buffers;
+    }
+
+    static thread_local ThreadBuffer* localBuffer = nullptr;
+    static thread_local const char* localName = nullptr;
+
+    static ThreadBuffer& threadBuffer() {
+        if (!localBuffer) {
+            std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+            buffer->records.resize(ThreadBuffer::CAPACITY);
+
+            std::lock_guard<std::mutex> lock(registryMutex());
+            buffer->id = (int)registry().size() + 1;
+            buffer->name = localName ? localName : "thread " + std::to_string(buffer->id);
+            localBuffer = buffer.get();
+            registry().push_back(std::move(buffer));
+        }
+        return *localBuffer;
+    }
+
+    uint64_t Profiler::now() {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count() + 1; // 0 means "not recording"
+    }
+
+    bool Profiler::capturing() {
+        return captureActive.load(std::memory_order_relaxed);
+    }
+
+    void Profiler::beginCapture() {
+        captureStart = now();
+        captureEnd = 0;
+        ringsClosed = false;
+        captureActive = true;
+    }
+
+    void Profiler::endCapture() {
+        captureActive = false;
+        captureEnd = now();
+        ringsClosed = true;
+    }
+
+    void Profiler::setThreadName(const char* name) {
+        localName = name;
+        if (localBuffer) {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            localBuffer->name = name;
+        }
+    }
+
+    void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+        ThreadBuffer& b = threadBuffer();
+
+        // announce the write before checking, so a reader closing the rings either
+        // sees it and waits, or is seen here (both sequentially consistent)
+        b.writing.store(true);
+        if (ringsClosed.load()) {
+            b.writing.store(false, std::memory_order_release);
+            return;
+        }
+        uint64_t n = b.written.load(std::memory_order_relaxed);
+        b.records[n % ThreadBuffer::CAPACITY] = ZoneRecord{ name, start, end };
+        b.written.store(n + 1, std::memory_order_release);
+        b.writing.store(false, std::memory_order_release);
+    }
+
+    static void writeEscaped(std::ostream& out, const std::string& s) {
+        for (char c : s) {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+    }
+
+    bool Profiler::writeChromeTrace(const std::string& fileName) {
+        std::ofstream out(fileName);
+        if (!out) {
+            std::cout << "ERROR: could not write trace " << fileName << std::endl;
+            return false;
+        }
+
+        uint64_t end = captureEnd ? captureEnd : now();
+        size_t zones = 0;
+
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+
+        // close the rings (a trace taken mid-capture too) and let writes in flight finish
+        std::lock_guard<std::mutex> lock(registryMutex());
+        bool wasClosed = ringsClosed.exchange(true);
+        for (const auto& b : registry())
+            while (b->writing.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+        for (const auto& b : registry()) {
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->id
+                << ",\"args\":{\"name\":\"";
+            writeEscaped(out, b->name);
+            out << "\"}}";
+            first = false;
+
+            uint64_t written = b->written.load(std::memory_order_acquire);
+            uint64_t oldest = written > ThreadBuffer::CAPACITY ? written - ThreadBuffer::CAPACITY : 0;
+            for (uint64_t i = oldest; i < written; i++) {
+                const ZoneRecord& r = b->records[i % ThreadBuffer::CAPACITY];
+                if (r.start < captureStart || r.end > end)
+                    continue;
+
+                // timestamps in microseconds
+                out << ",\n{\"name\":\"";
+                writeEscaped(out, r.name);
+                out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->id
+                    << ",\"ts\":" << (double)(r.start - captureStart) / 1000.0
+                    << ",\"dur\":" << (double)(r.end - r.start) / 1000.0 << "}";
+                zones++;
+            }
+        }
+        out << "\n]}\n";
+        if (!wasClosed)
+            ringsClosed = false;
+
+        std::cout << "Trace: " << zones << " zones written to " << fileName << std::endl;
+        return (bool)out;
+    }
+
+    void Profiler::benchmark(int zones) {
+        auto nsPerZone = [zones]() {
+            uint64_t start = now();
+            for (int i = 0; i < zones; i++) {
+                PROFILE_ZONE("benchmark");
+            }
+            return (double)(now() - start) / zones;
+        };
+
+        double idle = nsPerZone();
+        beginCapture();
+        double active = nsPerZone();
+        endCapture();
+
+        std::cout << "Profiler: " << zones << " zones, " << idle << " ns/zone idle, "
+            << active << " ns/zone capturing" << std::endl;
+    }
+}
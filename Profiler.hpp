@@ -0,0 +1,64 @@
+#ifndef Profiler_hpp
+#define Profiler_hpp
+
+#include <cstdint>
+#include <string>
+
+// build with -DGPS_NO_PROFILER to compile every PROFILE_ZONE out
+#if !defined(GPS_NO_PROFILER)
+#define GPS_PROFILER 1
+#endif
+
+namespace gps {
+
+    // CPU zone profiler: each thread appends (name, start, end) records to its
+    // own ring buffer, so recording takes no locks. Zones are only recorded
+    // during a capture, which is written out as Chrome trace-event JSON
+    // (chrome://tracing, ui.perfetto.dev).
+    class Profiler {
+
+    public:
+        // nanoseconds on the steady clock
+        static uint64_t now();
+        static bool capturing();
+
+        static void beginCapture();
+        static void endCapture();
+        // zones of the last capture; older ones may have been overwritten by ring wrap-around
+        static bool writeChromeTrace(const std::string& fileName);
+
+        // label for this thread in the trace
+        static void setThreadName(const char* name);
+
+        static void record(const char* name, uint64_t start, uint64_t end);
+
+        // cost of a zone while capturing and while not
+        static void benchmark(int zones);
+    };
+
+    class ProfileZone {
+
+    public:
+        explicit ProfileZone(const char* name) : name(name), start(Profiler::capturing() ? Profiler::now() : 0) {}
+        ~ProfileZone() { if (start) Profiler::record(name, start, Profiler::now()); }
+
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+
+    private:
+        const char* name;
+        uint64_t start;
+    };
+}
+
+#define GPS_PROFILE_CONCAT2(a, b) a##b
+#define GPS_PROFILE_CONCAT(a, b) GPS_PROFILE_CONCAT2(a, b)
+
+#if defined(GPS_PROFILER)
+// times the rest of the enclosing scope; name must be a string literal
+#define PROFILE_ZONE(name) gps::ProfileZone GPS_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+
+#endif /* Profiler_hpp */
@@ -0,0 +1,116 @@
+#include "RadixSort.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+
+namespace gps {
+
+    void RadixSort::sort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, gps::JobSystem* jobs) {
+        const int count = (int)keys.size();
+        const int blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (count < 2)
+            return;
+
+        scratchKeys.resize(count);
+        scratchValues.resize(count);
+        histograms.resize((size_t)blocks * RADIX);
+
+        uint32_t* srcKeys = keys.data();
+        uint32_t* srcValues = values.data();
+        uint32_t* dstKeys = scratchKeys.data();
+        uint32_t* dstValues = scratchValues.data();
+
+        auto forEachBlock = [&](const std::function<void(int)>& job) {
+            if (jobs && blocks > 1) {
+                jobs->parallelFor(0, blocks, 1, [&](int first, int last) {
+                    for (int b = first; b < last; b++) job(b);
+                });
+            }
+            else {
+                for (int b = 0; b < blocks; b++) job(b);
+            }
+        };
+
+        for (int shift = 0; shift < 32; shift += 8) {
+            // per-block digit counts
+            forEachBlock([&](int b) {
+                uint32_t* h = &histograms[(size_t)b * RADIX];
+                std::fill(h, h + RADIX, 0u);
+                int end = std::min(count, (b + 1) * BLOCK_SIZE);
+                for (int i = b * BLOCK_SIZE; i < end; i++)
+                    h[(srcKeys[i] >> shift) & 0xFF]++;
+            });
+
+            // exclusive prefix over (digit, block) gives each block its output slots
+            uint32_t sum = 0;
+            for (int d = 0; d < RADIX; d++) {
+                for (int b = 0; b < blocks; b++) {
+                    uint32_t& h = histograms[(size_t)b * RADIX + d];
+                    uint32_t c = h;
+                    h = sum;
+                    sum += c;
+                }
+            }
+
+            // stable scatter
+            forEachBlock([&](int b) {
+                uint32_t* offsets = &histograms[(size_t)b * RADIX];
+                int end = std::min(count, (b + 1) * BLOCK_SIZE);
+                for (int i = b * BLOCK_SIZE; i < end; i++) {
+                    uint32_t slot = offsets[(srcKeys[i] >> shift) & 0xFF]++;
+                    dstKeys[slot] = srcKeys[i];
+                    dstValues[slot] = srcValues[i];
+                }
+            });
+
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcValues, dstValues);
+        }
+
+        // four passes: the result is back in the caller's arrays
+    }
+
+    void RadixSort::benchmark(const std::vector<int>& sizes, int maxThreads) {
+        typedef std::chrono::steady_clock clock;
+        const int runs = 20;
+
+        for (int n : sizes) {
+            std::vector<uint32_t> sourceKeys(n);
+            uint32_t rng = 1234u;
+            for (auto& k : sourceKeys) {
+                rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                k = floatKey((rng & 0xFFFF) / 256.0f);
+            }
+
+            std::vector<uint32_t> keys, values(n);
+            std::vector<std::pair<uint32_t, uint32_t>> pairs(n);
+
+            auto start = clock::now();
+            for (int r = 0; r < runs; r++) {
+                for (int i = 0; i < n; i++) pairs[i] = { sourceKeys[i], (uint32_t)i };
+                std::sort(pairs.begin(), pairs.end());
+            }
+            double stdMs = std::chrono::duration<double, std::milli>(clock::now() - start).count() / runs;
+
+            std::cout << "Depth sort, " << n << " petals: std::sort " << stdMs << " ms" << std::endl;
+
+            for (int threads = 1; threads <= maxThreads; threads++) {
+                JobSystem jobs;
+                jobs.start(threads - 1);
+                RadixSort sorter;
+
+                start = clock::now();
+                for (int r = 0; r < runs; r++) {
+                    keys = sourceKeys;
+                    std::iota(values.begin(), values.end(), 0u);
+                    sorter.sort(keys, values, &jobs);
+                }
+                double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / runs;
+
+                std::cout << "  radix, " << threads << " thread(s): " << ms << " ms" << std::endl;
+            }
+        }
+    }
+}
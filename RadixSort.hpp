@@ -0,0 +1,40 @@
+#ifndef RadixSort_hpp
+#define RadixSort_hpp
+
+#include "JobSystem.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace gps {
+
+    // LSD radix sort of (key, value) pairs by ascending 32-bit key, 8 bits per pass.
+    // Histograms and scatters run per block as jobs when a JobSystem is given.
+    class RadixSort {
+
+    public:
+        void sort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, gps::JobSystem* jobs = nullptr);
+
+        // maps a float to a key with the same ordering
+        static inline uint32_t floatKey(float f) {
+            union { float f; uint32_t u; } bits;
+            bits.f = f;
+            uint32_t mask = (bits.u & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+            return bits.u ^ mask;
+        }
+
+        // prints sort time for the given sizes, serial std::sort vs radix on 1..maxThreads threads
+        static void benchmark(const std::vector<int>& sizes, int maxThreads);
+
+    private:
+        static const int BLOCK_SIZE = 16384;
+        static const int RADIX = 256;
+
+        std::vector<uint32_t> scratchKeys;
+        std::vector<uint32_t> scratchValues;
+        // RADIX counters per block, turned into scatter offsets in place
+        std::vector<uint32_t> histograms;
+    };
+}
+
+#endif /* RadixSort_hpp */
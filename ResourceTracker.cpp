@@ -0,0 +1,136 @@
+#include "ResourceTracker.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace gps {
+
+    struct TrackedResource {
+        std::string owner;
+        std::string group;
+        bool buffer;
+        long long gpuBytes;
+        long long cpuBytes;
+    };
+
+    // never destroyed: global models and particle systems untrack from their destructors,
+    // which run after function-local statics first used during main are gone
+    static std::mutex& trackerMutex() {
+        static std::mutex* m = new std::mutex;
+        return *m;
+    }
+
+    static std::map<std::pair<int, GLuint>, TrackedResource>& resources() {
+        static auto* r = new std::map<std::pair<int, GLuint>, TrackedResource>;
+        return *r;
+    }
+
+    void ResourceTracker::Totals::add(const Totals& o) {
+        bufferBytes += o.bufferBytes;
+        textureBytes += o.textureBytes;
+        cpuBytes += o.cpuBytes;
+        buffers += o.buffers;
+        textures += o.textures;
+    }
+
+    static ResourceTracker::Totals totalsOf(const TrackedResource& r) {
+        ResourceTracker::Totals t;
+        if (r.buffer) {
+            t.bufferBytes = r.gpuBytes;
+            t.buffers = 1;
+        }
+        else {
+            t.textureBytes = r.gpuBytes;
+            t.textures = 1;
+        }
+        t.cpuBytes = r.cpuBytes;
+        return t;
+    }
+
+    void ResourceTracker::add(Kind kind, GLuint id, const std::string& owner, const std::string& group,
+        long long gpuBytes, long long cpuBytes) {
+        if (id == 0)
+            return;
+        std::lock_guard<std::mutex> lock(trackerMutex());
+        resources()[{ (int)kind, id }] = TrackedResource{ owner, group, kind == Kind::Buffer, gpuBytes, cpuBytes };
+    }
+
+    void ResourceTracker::remove(Kind kind, GLuint id) {
+        std::lock_guard<std::mutex> lock(trackerMutex());
+        resources().erase({ (int)kind, id });
+    }
+
+    ResourceTracker::Totals ResourceTracker::totals() {
+        std::lock_guard<std::mutex> lock(trackerMutex());
+        Totals t;
+        for (const auto& r : resources())
+            t.add(totalsOf(r.second));
+        return t;
+    }
+
+    static std::string megabytes(long long bytes) {
+        char s[32];
+        std::snprintf(s, sizeof(s), "%9.2f MB", bytes / (1024.0 * 1024.0));
+        return s;
+    }
+
+    std::string ResourceTracker::report() {
+        std::map<std::string, std::map<std::string, Totals>> groups;
+        {
+            std::lock_guard<std::mutex> lock(trackerMutex());
+            for (const auto& r : resources())
+                groups[r.second.owner][r.second.group].add(totalsOf(r.second));
+        }
+
+        std::vector<std::pair<std::string, Totals>> owners;
+        Totals all;
+        for (const auto& o : groups) {
+            Totals t;
+            for (const auto& g : o.second)
+                t.add(g.second);
+            owners.push_back({ o.first, t });
+            all.add(t);
+        }
+        auto gpuBytes = [](const Totals& t) { return t.bufferBytes + t.textureBytes; };
+        std::sort(owners.begin(), owners.end(), [&](const std::pair<std::string, Totals>& a, const std::pair<std::string, Totals>& b) {
+            return gpuBytes(a.second) > gpuBytes(b.second);
+        });
+
+        std::ostringstream out;
+        char line[256];
+        auto row = [&](const std::string& name, const Totals& t) {
+            std::snprintf(line, sizeof(line), "%-44.44s %4d %s %4d %s %s\n", name.c_str(),
+                t.buffers, megabytes(t.bufferBytes).c_str(), t.textures, megabytes(t.textureBytes).c_str(),
+                megabytes(t.cpuBytes).c_str());
+            out << line;
+        };
+
+        std::snprintf(line, sizeof(line), "%-44s %4s %12s %4s %12s %12s\n", "Memory by owner / group",
+            "#", "buffers", "#", "textures", "CPU copies");
+        out << line;
+        for (const auto& o : owners) {
+            row(o.first, o.second);
+            for (const auto& g : groups[o.first])
+                row("    " + g.first, g.second);
+        }
+        row("total", all);
+        return out.str();
+    }
+
+    long long ResourceTracker::textureBytes(int width, int height, int bytesPerTexel, bool mipmapped) {
+        long long bytes = 0;
+        while (true) {
+            bytes += (long long)width * height * bytesPerTexel;
+            if (!mipmapped || (width == 1 && height == 1))
+                break;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return bytes;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef ResourceTracker_hpp
+#define ResourceTracker_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include <string>
+
+namespace gps {
+
+    // bytes held by each GL buffer, texture and renderbuffer, plus any CPU copy
+    // kept next to it, grouped by owner (a model file, "renderer", ...) and group
+    // (a material, a render target, ...). GPU sizes are computed from the
+    // formats, so they are what the data needs, not what the driver allocates.
+    class ResourceTracker {
+
+    public:
+        enum class Kind { Buffer, Texture, Renderbuffer };
+
+        struct Totals {
+            long long bufferBytes = 0;   // buffers
+            long long textureBytes = 0;  // textures and renderbuffers
+            long long cpuBytes = 0;
+            int buffers = 0;
+            int textures = 0;
+
+            void add(const Totals& o);
+        };
+
+        // tracking an id again replaces its entry (reallocation, resize)
+        static void add(Kind kind, GLuint id, const std::string& owner, const std::string& group,
+            long long gpuBytes, long long cpuBytes = 0);
+        static void remove(Kind kind, GLuint id);
+
+        static Totals totals();
+        // per owner and group, largest owners first
+        static std::string report();
+
+        // a width x height texture with bytesPerTexel, plus its mip chain if mipmapped
+        static long long textureBytes(int width, int height, int bytesPerTexel, bool mipmapped);
+    };
+}
+
+#endif /* ResourceTracker_hpp */
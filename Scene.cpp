@@ -0,0 +1,234 @@
+#include "Scene.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace gps {
+
+    static const uint32_t SCENE_MAGIC = 0x4e435347u; // "GSCN"
+    static const uint32_t SCENE_VERSION = 2u;
+
+    static bool readVec3(std::istream& in, glm::vec3& v) {
+        return (bool)(in >> v.x >> v.y >> v.z);
+    }
+
+    void Scene::clear() {
+        *this = Scene();
+    }
+
+    const SceneModel* Scene::findModel(const std::string& name) const {
+        for (const SceneModel& m : models)
+            if (m.name == name) return &m;
+        return nullptr;
+    }
+
+    bool Scene::load(const std::string& fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file) {
+            std::cout << "ERROR: could not open scene " << fileName << std::endl;
+            return false;
+        }
+
+        clear();
+
+        uint32_t magic = 0;
+        file.read((char*)&magic, sizeof(magic));
+        if (file && magic == SCENE_MAGIC)
+            return readBinary(file, fileName);
+
+        file.clear();
+        file.seekg(0);
+        return parseText(file, fileName);
+    }
+
+    bool Scene::parseText(std::istream& in, const std::string& fileName) {
+        std::string line;
+        int lineNumber = 0;
+        bool haveBounds = false;
+
+        while (std::getline(in, line)) {
+            lineNumber++;
+
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+
+            std::istringstream ls(line);
+            std::string keyword;
+            if (!(ls >> keyword)) continue;
+
+            bool ok = true;
+            if (keyword == "model") {
+                SceneModel m;
+                ok = (bool)(ls >> m.name >> m.path) && readVec3(ls, m.position) && readVec3(ls, m.rotation)
+                    && (bool)(ls >> m.scale);
+                std::string flag;
+                while (ok && ls >> flag) {
+                    if (flag == "collide") m.collide = true;
+                    else if (flag == "parent") ok = (bool)(ls >> m.parent) && findModel(m.parent);
+                    else ok = false;
+                }
+                if (ok) models.push_back(m);
+            }
+            else if (keyword == "sun") {
+                ok = readVec3(ls, sunDirection) && readVec3(ls, sunColor);
+            }
+            else if (keyword == "lamp") {
+                SceneLight l;
+                ok = readVec3(ls, l.position) && readVec3(ls, l.color);
+                if (ok) lamps.push_back(l);
+            }
+            else if (keyword == "emitter") {
+                glm::vec3 p;
+                ok = readVec3(ls, p);
+                if (ok) emitters.push_back(p);
+            }
+            else if (keyword == "collider") {
+                AABB b;
+                ok = readVec3(ls, b.min) && readVec3(ls, b.max);
+                if (ok) colliders.push_back(b);
+            }
+            else if (keyword == "bounds") {
+                ok = (bool)(ls >> boundsX.x >> boundsX.y >> boundsZ.x >> boundsZ.y >> floorY >> ceilingY);
+                haveBounds = ok;
+            }
+            else if (keyword == "camera") {
+                ok = readVec3(ls, cameraPosition) && readVec3(ls, cameraTarget);
+            }
+            else if (keyword == "path") {
+                glm::vec3 p;
+                ok = readVec3(ls, p);
+                if (ok) cameraPath.push_back(p);
+            }
+            else {
+                std::cout << "ERROR: " << fileName << ":" << lineNumber << ": unknown directive '" << keyword << "'" << std::endl;
+                return false;
+            }
+
+            if (!ok) {
+                std::cout << "ERROR: " << fileName << ":" << lineNumber << ": malformed '" << keyword << "' line" << std::endl;
+                return false;
+            }
+        }
+
+        if (models.empty()) {
+            std::cout << "ERROR: scene " << fileName << " has no models" << std::endl;
+            return false;
+        }
+        if (!haveBounds)
+            std::cout << "WARNING: scene " << fileName << " has no bounds, using defaults" << std::endl;
+
+        sunDirection = glm::normalize(sunDirection);
+        return true;
+    }
+
+    // binary layout: magic, version, then every field in declaration order;
+    // strings and arrays are prefixed with a uint32 count, floats are raw
+    template <typename T>
+    static void writePod(std::ostream& out, const T& v) {
+        out.write((const char*)&v, sizeof(T));
+    }
+
+    template <typename T>
+    static bool readPod(std::istream& in, T& v) {
+        return (bool)in.read((char*)&v, sizeof(T));
+    }
+
+    static void writeString(std::ostream& out, const std::string& s) {
+        writePod(out, (uint32_t)s.size());
+        out.write(s.data(), s.size());
+    }
+
+    static bool readString(std::istream& in, std::string& s) {
+        uint32_t n = 0;
+        if (!readPod(in, n) || n > 4096) return false;
+        s.resize(n);
+        return n == 0 || (bool)in.read(&s[0], n);
+    }
+
+    template <typename T>
+    static void writeArray(std::ostream& out, const std::vector<T>& v) {
+        writePod(out, (uint32_t)v.size());
+        if (!v.empty()) out.write((const char*)v.data(), v.size() * sizeof(T));
+    }
+
+    template <typename T>
+    static bool readArray(std::istream& in, std::vector<T>& v) {
+        uint32_t n = 0;
+        if (!readPod(in, n) || n > (1u << 20)) return false;
+        v.resize(n);
+        return n == 0 || (bool)in.read((char*)v.data(), n * sizeof(T));
+    }
+
+    bool Scene::saveBinary(const std::string& fileName) const {
+        std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cout << "ERROR: could not write scene " << fileName << std::endl;
+            return false;
+        }
+
+        writePod(out, SCENE_MAGIC);
+        writePod(out, SCENE_VERSION);
+
+        writePod(out, (uint32_t)models.size());
+        for (const SceneModel& m : models) {
+            writeString(out, m.name);
+            writeString(out, m.path);
+            writePod(out, m.position);
+            writePod(out, m.rotation);
+            writePod(out, m.scale);
+            writePod(out, (uint32_t)m.collide);
+            writeString(out, m.parent);
+        }
+
+        writePod(out, sunDirection);
+        writePod(out, sunColor);
+        writeArray(out, lamps);
+        writeArray(out, emitters);
+        writeArray(out, colliders);
+        writePod(out, boundsX);
+        writePod(out, boundsZ);
+        writePod(out, floorY);
+        writePod(out, ceilingY);
+        writePod(out, cameraPosition);
+        writePod(out, cameraTarget);
+        writeArray(out, cameraPath);
+
+        return (bool)out;
+    }
+
+    bool Scene::readBinary(std::istream& in, const std::string& fileName) {
+        uint32_t version = 0, modelCount = 0;
+        bool ok = readPod(in, version) && version == SCENE_VERSION && readPod(in, modelCount) && modelCount < 4096;
+
+        for (uint32_t i = 0; ok && i < modelCount; i++) {
+            SceneModel m;
+            uint32_t collide = 0;
+            ok = readString(in, m.name) && readString(in, m.path) && readPod(in, m.position)
+                && readPod(in, m.rotation) && readPod(in, m.scale) && readPod(in, collide)
+                && readString(in, m.parent);
+            m.collide = collide != 0;
+
+            // as in the text format, parents must be listed before their children
+            if (ok && !m.parent.empty() && !findModel(m.parent)) {
+                std::cout << "ERROR: scene " << fileName << ": model " << m.name
+                    << " has unknown parent " << m.parent << std::endl;
+                return false;
+            }
+            models.push_back(m);
+        }
+
+        ok = ok && readPod(in, sunDirection) && readPod(in, sunColor)
+            && readArray(in, lamps) && readArray(in, emitters) && readArray(in, colliders)
+            && readPod(in, boundsX) && readPod(in, boundsZ) && readPod(in, floorY) && readPod(in, ceilingY)
+            && readPod(in, cameraPosition) && readPod(in, cameraTarget) && readArray(in, cameraPath);
+
+        if (!ok) {
+            std::cout << "ERROR: scene " << fileName << " is truncated or from another version" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
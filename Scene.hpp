@@ -0,0 +1,77 @@
+#ifndef Scene_hpp
+#define Scene_hpp
+
+#include <glm/glm.hpp>
+
+#include "Collision.hpp"
+
+#include <string>
+#include <vector>
+
+namespace gps {
+
+    struct SceneModel {
+        std::string name;
+        std::string path;
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 rotation = glm::vec3(0.0f); // degrees
+        float scale = 1.0f;
+        // derive camera colliders and ground triangles from this model
+        bool collide = false;
+        // name of an earlier model this one is placed relative to ("" = world)
+        std::string parent;
+    };
+
+    struct SceneLight {
+        glm::vec3 position;
+        glm::vec3 color;
+    };
+
+    // data-driven scene: model instances, lights, petal emitters, colliders and
+    // the presentation camera path. Text files have one directive per line:
+    //
+    //   model <name> <obj path> <x y z> <rx ry rz> <scale> [collide] [parent <name>]
+    //   sun <dx dy dz> <r g b>
+    //   lamp <x y z> <r g b>
+    //   emitter <x y z>
+    //   collider <min xyz> <max xyz>
+    //   bounds <minX maxX> <minZ maxZ> <floorY ceilingY>
+    //   camera <x y z> <target xyz>
+    //   path <x y z>
+    //
+    // '#' starts a comment. load() also accepts the binary form written by saveBinary().
+    class Scene {
+
+    public:
+        bool load(const std::string& fileName);
+        bool saveBinary(const std::string& fileName) const;
+
+        const SceneModel* findModel(const std::string& name) const;
+
+        std::vector<SceneModel> models;
+
+        glm::vec3 sunDirection = glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 sunColor = glm::vec3(1.0f);
+        std::vector<SceneLight> lamps;
+
+        std::vector<glm::vec3> emitters;
+        std::vector<gps::AABB> colliders;
+
+        // walkable area and camera floor / ceiling
+        glm::vec2 boundsX = glm::vec2(-10.0f, 10.0f);
+        glm::vec2 boundsZ = glm::vec2(-10.0f, 10.0f);
+        float floorY = 0.75f;
+        float ceilingY = 3.8f;
+
+        glm::vec3 cameraPosition = glm::vec3(0.0f, 2.0f, 5.0f);
+        glm::vec3 cameraTarget = glm::vec3(0.0f);
+        std::vector<glm::vec3> cameraPath;
+
+    private:
+        void clear();
+        bool parseText(std::istream& in, const std::string& fileName);
+        bool readBinary(std::istream& in, const std::string& fileName);
+    };
+}
+
+#endif /* Scene_hpp */
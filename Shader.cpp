@@ -7,8 +7,18 @@
 //
 
 #include "Shader.hpp"
+#include "Profiler.hpp"
+#include "GLStatsHooks.hpp"
+
+// GL_KHR_parallel_shader_compile; not in the macOS headers
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 namespace gps {
+
+    bool Shader::parallelCompile = false;
+
     std::string Shader::readShaderFile(std::string fileName) {
 
         std::ifstream shaderFile;
@@ -58,41 +68,117 @@ namespace gps {
         }
     }
     
-    void Shader::loadShader(std::string vertexShaderFileName, std::string fragmentShaderFileName) {
+    GLuint Shader::compileShader(GLenum type, std::string fileName) {
+        PROFILE_ZONE("Shader::compileShader");
 
-        //read, parse and compile the vertex shader
-        std::string v = readShaderFile(vertexShaderFileName);
-        const GLchar* vertexShaderString = v.c_str();
-        GLuint vertexShader;
-        vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &vertexShaderString, NULL);
-        glCompileShader(vertexShader);
-        //check compilation status
-        shaderCompileLog(vertexShader);
-        
-        //read, parse and compile the vertex shader
-        std::string f = readShaderFile(fragmentShaderFileName);
-        const GLchar* fragmentShaderString = f.c_str();
-        GLuint fragmentShader;
-        fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &fragmentShaderString, NULL);
-        glCompileShader(fragmentShader);
-        //check compilation status
-        shaderCompileLog(fragmentShader);
-        
-        //attach and link the shader programs
+        //read, parse and submit the shader; the compile status is checked later
+        std::string source = readShaderFile(fileName);
+        const GLchar* shaderString = source.c_str();
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &shaderString, NULL);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    void Shader::enableParallelCompile() {
+
+#if not defined (__APPLE__)
+        if (GLEW_KHR_parallel_shader_compile) {
+            //let the driver pick the number of compiler threads
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            parallelCompile = true;
+        }
+        else if (GLEW_ARB_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+            parallelCompile = true;
+        }
+#endif
+        std::cout << "Parallel shader compile: " << (parallelCompile ? "ON" : "OFF") << std::endl;
+    }
+
+    void Shader::submitShader(std::string vertexShaderFileName, std::string fragmentShaderFileName) {
+
+        vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderFileName);
+        fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderFileName);
+
+        //attach and link right away, without waiting for the compile results
         this->shaderProgram = glCreateProgram();
         glAttachShader(this->shaderProgram, vertexShader);
         glAttachShader(this->shaderProgram, fragmentShader);
         glLinkProgram(this->shaderProgram);
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
+
+        pending = true;
+    }
+
+    void Shader::submitFeedbackShader(std::string vertexShaderFileName, const std::vector<std::string>& varyings) {
+
+        vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderFileName);
+        fragmentShader = 0;
+
+        this->shaderProgram = glCreateProgram();
+        glAttachShader(this->shaderProgram, vertexShader);
+
+        //captured outputs must be declared before linking
+        std::vector<const GLchar*> names;
+        for (const auto& v : varyings) names.push_back(v.c_str());
+        glTransformFeedbackVaryings(this->shaderProgram, (GLsizei)names.size(), names.data(), GL_INTERLEAVED_ATTRIBS);
+
+        glLinkProgram(this->shaderProgram);
+
+        pending = true;
+    }
+
+    bool Shader::isReady() {
+
+        if (!pending)
+            return true;
+
+        //without the extension any status query blocks, so leave the program to its first use
+        if (!parallelCompile)
+            return false;
+
+        GLint done = GL_FALSE;
+        glGetProgramiv(this->shaderProgram, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+
+    void Shader::finishShader() {
+
+        if (!pending)
+            return;
+
+        PROFILE_ZONE("Shader::finishShader");
+
+        pending = false;
+
+        //check compilation status
+        shaderCompileLog(vertexShader);
+        if (fragmentShader) shaderCompileLog(fragmentShader);
         //check linking info
         shaderLinkLog(this->shaderProgram);
+
+        glDetachShader(this->shaderProgram, vertexShader);
+        glDeleteShader(vertexShader);
+        if (fragmentShader) {
+            glDetachShader(this->shaderProgram, fragmentShader);
+            glDeleteShader(fragmentShader);
+        }
+        vertexShader = 0;
+        fragmentShader = 0;
+    }
+
+    void Shader::loadShader(std::string vertexShaderFileName, std::string fragmentShaderFileName) {
+
+        submitShader(vertexShaderFileName, fragmentShaderFileName);
+        finishShader();
     }
     
     void Shader::useShaderProgram()
     {
+        //first use resolves a submitted program
+        if (pending)
+            finishShader();
+
         if (shaderProgram != 0)
             glUseProgram(shaderProgram);
     }
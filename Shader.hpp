@@ -20,6 +20,8 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 
 namespace gps {
@@ -27,12 +29,33 @@ namespace gps {
     class Shader {
 
     public:
-        GLuint shaderProgram;
+        GLuint shaderProgram = 0;
         void loadShader(std::string vertexShaderFileName, std::string fragmentShaderFileName);
         void useShaderProgram();
-    
+
+        // issue compile + link and return immediately; the status is only
+        // queried when the program is first needed (finishShader / useShaderProgram)
+        void submitShader(std::string vertexShaderFileName, std::string fragmentShaderFileName);
+        // vertex-only program whose outputs are captured with transform feedback (interleaved)
+        void submitFeedbackShader(std::string vertexShaderFileName, const std::vector<std::string>& varyings);
+        // true once the driver finished compiling; never blocks, and without
+        // KHR_parallel_shader_compile a submitted program is never reported ready
+        bool isReady();
+        // wait for the program and print compile/link logs
+        void finishShader();
+
+        // lets the driver compile on its own threads when GL_KHR_parallel_shader_compile is present
+        static void enableParallelCompile();
+
     private:
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        bool pending = false;
+
+        static bool parallelCompile;
+
         std::string readShaderFile(std::string fileName);
+        GLuint compileShader(GLenum type, std::string fileName);
         void shaderCompileLog(GLuint shaderId);
         void shaderLinkLog(GLuint shaderProgramId);
     };
@@ -0,0 +1,232 @@
+#include "TextureCache.hpp"
+#include "MipGenerator.hpp"
+#include "Profiler.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace gps {
+
+    bool TextureCache::cacheEnabled = true;
+
+    // bump when the encoder output changes, so old cache files are rebuilt
+    static const char* ENCODER_VERSION = "bc-2";
+    static const char* SOURCE_KEY = "gps.source";
+
+    static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    static const size_t KTX2_HEADER_BYTES = 80; // identifier, header and index
+    static const size_t KTX2_LEVEL_BYTES = 24;  // one level index entry
+
+    // VkFormat values of the block formats
+    static uint32_t vkFormat(TextureCompressor::Format format, bool srgb) {
+        switch (format) {
+        case TextureCompressor::Format::BC1: return srgb ? 132u : 131u;
+        case TextureCompressor::Format::BC3: return srgb ? 138u : 137u;
+        case TextureCompressor::Format::BC4: return 139u;
+        case TextureCompressor::Format::BC5: return 141u;
+        }
+        return 0u;
+    }
+
+    static bool fromVkFormat(uint32_t vk, TextureCompressor::Format& format, bool& srgb) {
+        switch (vk) {
+        case 131u: case 132u: format = TextureCompressor::Format::BC1; srgb = vk == 132u; return true;
+        case 137u: case 138u: format = TextureCompressor::Format::BC3; srgb = vk == 138u; return true;
+        case 139u: format = TextureCompressor::Format::BC4; srgb = false; return true;
+        case 141u: format = TextureCompressor::Format::BC5; srgb = false; return true;
+        }
+        return false;
+    }
+
+    // Khronos data format descriptor: one basic block describing the 4x4 blocks
+    static std::vector<uint32_t> dataFormatDescriptor(TextureCompressor::Format format, bool srgb) {
+        struct Sample { uint32_t bitOffset, bitLength, channel; bool linear; };
+        std::vector<Sample> samples;
+        uint32_t colorModel = 0;
+        switch (format) {
+        case TextureCompressor::Format::BC1: colorModel = 128; samples = { { 0, 64, 0, false } }; break;
+        case TextureCompressor::Format::BC3: colorModel = 130; samples = { { 0, 64, 15, true }, { 64, 64, 0, false } }; break;
+        case TextureCompressor::Format::BC4: colorModel = 131; samples = { { 0, 64, 0, false } }; break;
+        case TextureCompressor::Format::BC5: colorModel = 132; samples = { { 0, 64, 0, false }, { 64, 64, 1, false } }; break;
+        }
+
+        uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+        uint32_t transfer = srgb ? 2u : 1u; // sRGB or linear, BT.709 primaries
+        std::vector<uint32_t> dfd = {
+            4 + blockSize,
+            0,                                  // Khronos vendor, basic descriptor
+            2u | (blockSize << 16),             // version 2
+            colorModel | (1u << 8) | (transfer << 16),
+            3u | (3u << 8),                     // 4x4x1 texels
+            (uint32_t)TextureCompressor::blockBytes(format),
+            0
+        };
+        for (const Sample& s : samples) {
+            // alpha stays linear in sRGB formats
+            uint32_t qualifiers = (s.linear && srgb) ? 0x1u : 0x0u;
+            dfd.push_back(s.bitOffset | ((s.bitLength - 1) << 16) | (s.channel << 24) | (qualifiers << 28));
+            dfd.push_back(0);
+            dfd.push_back(0);
+            dfd.push_back(0xFFFFFFFFu);
+        }
+        return dfd;
+    }
+
+    static void put32(std::vector<uint8_t>& out, size_t at, uint32_t v) {
+        std::memcpy(out.data() + at, &v, sizeof(v));
+    }
+
+    static void put64(std::vector<uint8_t>& out, size_t at, uint64_t v) {
+        std::memcpy(out.data() + at, &v, sizeof(v));
+    }
+
+    static uint32_t get32(const std::vector<uint8_t>& in, size_t at) {
+        uint32_t v;
+        std::memcpy(&v, in.data() + at, sizeof(v));
+        return v;
+    }
+
+    static uint64_t get64(const std::vector<uint8_t>& in, size_t at) {
+        uint64_t v;
+        std::memcpy(&v, in.data() + at, sizeof(v));
+        return v;
+    }
+
+    static void appendKeyValue(std::vector<uint8_t>& kvd, const std::string& key, const std::string& value) {
+        uint32_t length = (uint32_t)(key.size() + 1 + value.size() + 1);
+        kvd.insert(kvd.end(), (const uint8_t*)&length, (const uint8_t*)&length + 4);
+        kvd.insert(kvd.end(), key.begin(), key.end());
+        kvd.push_back(0);
+        kvd.insert(kvd.end(), value.begin(), value.end());
+        kvd.push_back(0);
+        while (kvd.size() % 4) kvd.push_back(0);
+    }
+
+    std::string TextureCache::pathFor(const std::string& source) {
+        return source + ".ktx2";
+    }
+
+    std::string TextureCache::keyFor(const std::string& source, bool color) {
+        struct stat info;
+        if (stat(source.c_str(), &info) != 0)
+            return std::string();
+        const char* mips = MipGenerator::currentFilter() == MipGenerator::Filter::Box ? " box " : " kaiser ";
+        return std::to_string((long long)info.st_size) + " " + std::to_string((long long)info.st_mtime)
+            + (color ? " color" : " mask") + mips + ENCODER_VERSION;
+    }
+
+    bool TextureCache::save(const std::string& fileName, const std::string& key, const TextureCompressor::Image& image) {
+        PROFILE_ZONE("TextureCache::save");
+        uint32_t levelCount = (uint32_t)image.levels.size();
+        std::vector<uint32_t> dfd = dataFormatDescriptor(image.format, image.srgb);
+
+        // keys sorted by code point; rows are stored bottom row first (GL upload order)
+        std::vector<uint8_t> kvd;
+        appendKeyValue(kvd, "KTXorientation", "ru");
+        appendKeyValue(kvd, SOURCE_KEY, key);
+
+        size_t dfdOffset = KTX2_HEADER_BYTES + KTX2_LEVEL_BYTES * levelCount;
+        size_t kvdOffset = dfdOffset + dfd.size() * 4;
+        size_t dataOffset = kvdOffset + kvd.size();
+        size_t alignment = (size_t)TextureCompressor::blockBytes(image.format);
+        dataOffset = (dataOffset + alignment - 1) / alignment * alignment;
+
+        std::vector<uint8_t> out(dataOffset + (size_t)image.bytes(), 0);
+        std::memcpy(out.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+        const uint32_t header[9] = { vkFormat(image.format, image.srgb), 1, (uint32_t)image.width(), (uint32_t)image.height(),
+            0, 0, 1, levelCount, 0 };
+        for (int i = 0; i < 9; i++)
+            put32(out, 12 + 4 * i, header[i]);
+        put32(out, 48, (uint32_t)dfdOffset);
+        put32(out, 52, (uint32_t)(dfd.size() * 4));
+        put32(out, 56, (uint32_t)kvdOffset);
+        put32(out, 60, (uint32_t)kvd.size());
+        std::memcpy(out.data() + dfdOffset, dfd.data(), dfd.size() * 4);
+        std::memcpy(out.data() + kvdOffset, kvd.data(), kvd.size());
+
+        // the smallest level comes first in the file, the index lists level 0 first
+        size_t offset = dataOffset;
+        for (uint32_t l = levelCount; l-- > 0;) {
+            const TextureCompressor::Level& level = image.levels[l];
+            std::memcpy(out.data() + offset, level.data.data(), level.data.size());
+            size_t entry = KTX2_HEADER_BYTES + KTX2_LEVEL_BYTES * l;
+            put64(out, entry, offset);
+            put64(out, entry + 8, level.data.size());
+            put64(out, entry + 16, level.data.size());
+            offset += level.data.size();
+        }
+
+        std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write((const char*)out.data(), out.size())) {
+            std::cout << "WARNING: could not write texture cache " << fileName << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool TextureCache::load(const std::string& fileName, const std::string& key, TextureCompressor::Image& image) {
+        PROFILE_ZONE("TextureCache::load");
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file)
+            return false;
+        std::vector<uint8_t> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        auto invalid = [&](const char* reason) {
+            std::cout << "WARNING: texture cache " << fileName << " " << reason << ", rebuilding" << std::endl;
+            return false;
+        };
+
+        if (in.size() < KTX2_HEADER_BYTES || std::memcmp(in.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+            return invalid("is not a KTX2 file");
+
+        TextureCompressor::Format format;
+        bool srgb;
+        uint32_t width = get32(in, 20), height = get32(in, 24), levelCount = get32(in, 40);
+        if (!fromVkFormat(get32(in, 12), format, srgb) || get32(in, 44) != 0 || get32(in, 36) != 1
+            || width == 0 || height == 0 || levelCount == 0 || levelCount > 32)
+            return invalid("has an unsupported format");
+
+        // find our key among the key/value pairs
+        size_t kvdOffset = get32(in, 56), kvdEnd = kvdOffset + get32(in, 60);
+        if (kvdEnd > in.size() || KTX2_HEADER_BYTES + KTX2_LEVEL_BYTES * levelCount > in.size())
+            return invalid("is truncated");
+        std::string storedKey;
+        for (size_t at = kvdOffset; at + 4 <= kvdEnd;) {
+            uint32_t length = get32(in, at);
+            if (length == 0 || at + 4 + length > kvdEnd)
+                break;
+            const char* entry = (const char*)in.data() + at + 4;
+            size_t keyLength = strnlen(entry, length);
+            if (keyLength < length && std::string(entry, keyLength) == SOURCE_KEY)
+                storedKey.assign(entry + keyLength + 1, strnlen(entry + keyLength + 1, length - keyLength - 1));
+            at += 4 + (length + 3) / 4 * 4;
+        }
+        if (storedKey != key)
+            return false;
+
+        image = TextureCompressor::Image();
+        image.format = format;
+        image.srgb = srgb;
+        int w = (int)width, h = (int)height;
+        for (uint32_t l = 0; l < levelCount; l++) {
+            size_t entry = KTX2_HEADER_BYTES + KTX2_LEVEL_BYTES * l;
+            uint64_t offset = get64(in, entry), length = get64(in, entry + 8);
+            if (length != (uint64_t)TextureCompressor::levelBytes(format, w, h) || offset + length > in.size())
+                return invalid("is truncated");
+
+            TextureCompressor::Level level;
+            level.width = w;
+            level.height = h;
+            level.data.assign(in.begin() + (size_t)offset, in.begin() + (size_t)(offset + length));
+            image.levels.push_back(std::move(level));
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef TextureCache_hpp
+#define TextureCache_hpp
+
+#include "TextureCompressor.hpp"
+
+#include <string>
+
+namespace gps {
+
+    // compressed textures stored as KTX2 next to their source ("wall.jpeg" ->
+    // "wall.jpeg.ktx2"), so later runs upload blocks straight from disk instead of
+    // decoding and compressing again. A cache file is used only while its key
+    // (source size and modification time, usage, mip filter, encoder version) still matches.
+    class TextureCache {
+
+    public:
+        static std::string pathFor(const std::string& source);
+        // empty when the source does not exist
+        static std::string keyFor(const std::string& source, bool color);
+
+        // false when missing, stale (other key) or unreadable
+        static bool load(const std::string& fileName, const std::string& key, TextureCompressor::Image& image);
+        static bool save(const std::string& fileName, const std::string& key, const TextureCompressor::Image& image);
+
+        // --no-texture-cache: compress on every load and write nothing
+        static void setEnabled(bool enabled) { cacheEnabled = enabled; }
+        static bool enabled() { return cacheEnabled; }
+
+    private:
+        static bool cacheEnabled;
+    };
+}
+
+#endif /* TextureCache_hpp */
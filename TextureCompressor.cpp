@@ -0,0 +1,497 @@
+#include "TextureCompressor.hpp"
+#include "MipGenerator.hpp"
+#include "Profiler.hpp"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace gps {
+
+    // ---- BC1 colour blocks ----
+
+    static uint16_t pack565(const float c[3]) {
+        int r = std::min(31, std::max(0, (int)(c[0] * 31.0f / 255.0f + 0.5f)));
+        int g = std::min(63, std::max(0, (int)(c[1] * 63.0f / 255.0f + 0.5f)));
+        int b = std::min(31, std::max(0, (int)(c[2] * 31.0f / 255.0f + 0.5f)));
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    static void unpack565(uint16_t v, int c[3]) {
+        int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        c[0] = (r << 3) | (r >> 2);
+        c[1] = (g << 2) | (g >> 4);
+        c[2] = (b << 3) | (b >> 2);
+    }
+
+    // four-colour palette: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+    static void colorPalette(uint16_t c0, uint16_t c1, int palette[4][3]) {
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for (int k = 0; k < 3; k++) {
+            palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+            palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+        }
+    }
+
+    // nearest palette entry per texel, 2 bits each; returns the squared error
+    static int fitColorIndices(const uint8_t texels[16][4], uint16_t c0, uint16_t c1, uint32_t& indices) {
+        int palette[4][3];
+        colorPalette(c0, c1, palette);
+
+        indices = 0;
+        int error = 0;
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int dr = texels[i][0] - palette[p][0];
+                int dg = texels[i][1] - palette[p][1];
+                int db = texels[i][2] - palette[p][2];
+                int e = dr * dr + dg * dg + db * db;
+                if (e < bestError) { bestError = e; best = p; }
+            }
+            indices |= (uint32_t)best << (2 * i);
+            error += bestError;
+        }
+        return error;
+    }
+
+    static void encodeColorBlock(const uint8_t texels[16][4], uint8_t* out) {
+        float mean[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; i++)
+            for (int k = 0; k < 3; k++)
+                mean[k] += texels[i][k] / 16.0f;
+
+        // principal axis of the colours (covariance, power iteration)
+        float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        float lo[3] = { 255.0f, 255.0f, 255.0f }, hi[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; i++) {
+            float r = texels[i][0] - mean[0], g = texels[i][1] - mean[1], b = texels[i][2] - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+            for (int k = 0; k < 3; k++) {
+                lo[k] = std::min(lo[k], (float)texels[i][k]);
+                hi[k] = std::max(hi[k], (float)texels[i][k]);
+            }
+        }
+        float axis[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+        for (int it = 0; it < 8; it++) {
+            float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+            float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+            float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+            float len = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+            if (len < 1e-6f)
+                break;
+            axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+        }
+        float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+        // endpoints at the extreme projections, pulled in by 1/16 of the range
+        float e0[3], e1[3];
+        if (axisLength < 1e-6f) {
+            for (int k = 0; k < 3; k++) e0[k] = e1[k] = mean[k];
+        }
+        else {
+            float tMin = 1e30f, tMax = -1e30f;
+            for (int k = 0; k < 3; k++) axis[k] /= axisLength;
+            for (int i = 0; i < 16; i++) {
+                float t = (texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1]
+                    + (texels[i][2] - mean[2]) * axis[2];
+                tMin = std::min(tMin, t);
+                tMax = std::max(tMax, t);
+            }
+            float inset = (tMax - tMin) / 16.0f;
+            tMin += inset;
+            tMax -= inset;
+            for (int k = 0; k < 3; k++) {
+                e0[k] = mean[k] + axis[k] * tMax;
+                e1[k] = mean[k] + axis[k] * tMin;
+            }
+        }
+
+        uint16_t c0 = pack565(e0), c1 = pack565(e1);
+        uint32_t indices;
+        int error = fitColorIndices(texels, c0, c1, indices);
+
+        // least-squares endpoints for the chosen indices
+        static const float weight0[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; i++) {
+            float a = weight0[(indices >> (2 * i)) & 3], b = 1.0f - a;
+            aa += a * a; bb += b * b; ab += a * b;
+            for (int k = 0; k < 3; k++) {
+                ax[k] += a * texels[i][k];
+                bx[k] += b * texels[i][k];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) > 1e-6f) {
+            for (int k = 0; k < 3; k++) {
+                e0[k] = std::min(255.0f, std::max(0.0f, (ax[k] * bb - bx[k] * ab) / det));
+                e1[k] = std::min(255.0f, std::max(0.0f, (bx[k] * aa - ax[k] * ab) / det));
+            }
+            uint16_t r0 = pack565(e0), r1 = pack565(e1);
+            uint32_t refined;
+            int refinedError = fitColorIndices(texels, r0, r1, refined);
+            if (refinedError < error) {
+                c0 = r0; c1 = r1; indices = refined;
+            }
+        }
+
+        // c0 > c1 selects the four-colour mode; swapping the endpoints swaps 0/1 and 2/3
+        if (c0 < c1) {
+            std::swap(c0, c1);
+            indices ^= 0x55555555u;
+        }
+        else if (c0 == c1) {
+            indices = 0;
+        }
+
+        out[0] = (uint8_t)(c0 & 0xff); out[1] = (uint8_t)(c0 >> 8);
+        out[2] = (uint8_t)(c1 & 0xff); out[3] = (uint8_t)(c1 >> 8);
+        for (int b = 0; b < 4; b++)
+            out[4 + b] = (uint8_t)(indices >> (8 * b));
+    }
+
+    static void decodeColorBlock(const uint8_t* in, uint8_t texels[16][4], bool allowThreeColor) {
+        uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8));
+        uint16_t c1 = (uint16_t)(in[2] | (in[3] << 8));
+        uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint32_t)in[7] << 24);
+
+        int palette[4][3];
+        colorPalette(c0, c1, palette);
+        bool threeColor = allowThreeColor && c0 <= c1;
+        if (threeColor) {
+            for (int k = 0; k < 3; k++) {
+                palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+                palette[3][k] = 0;
+            }
+        }
+        for (int i = 0; i < 16; i++) {
+            int p = (indices >> (2 * i)) & 3;
+            for (int k = 0; k < 3; k++)
+                texels[i][k] = (uint8_t)palette[p][k];
+            texels[i][3] = (threeColor && p == 3) ? 0 : 255;
+        }
+    }
+
+    // ---- BC4 single channel blocks (also BC3 alpha and both halves of BC5) ----
+
+    // a0 > a1: a0, a1 and six steps between them
+    static void channelPalette(int a0, int a1, int palette[8]) {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1) {
+            for (int i = 2; i < 8; i++)
+                palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+        else {
+            for (int i = 2; i < 6; i++)
+                palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    static void encodeChannelBlock(const uint8_t texels[16][4], int channel, uint8_t* out) {
+        int lo = 255, hi = 0;
+        for (int i = 0; i < 16; i++) {
+            lo = std::min(lo, (int)texels[i][channel]);
+            hi = std::max(hi, (int)texels[i][channel]);
+        }
+
+        out[0] = (uint8_t)hi;
+        out[1] = (uint8_t)lo;
+        uint64_t indices = 0;
+        if (hi > lo) {
+            int palette[8];
+            channelPalette(hi, lo, palette);
+            for (int i = 0; i < 16; i++) {
+                int v = texels[i][channel], best = 0;
+                for (int p = 1; p < 8; p++)
+                    if (std::abs(palette[p] - v) < std::abs(palette[best] - v)) best = p;
+                indices |= (uint64_t)best << (3 * i);
+            }
+        }
+        for (int b = 0; b < 6; b++)
+            out[2 + b] = (uint8_t)(indices >> (8 * b));
+    }
+
+    static void decodeChannelBlock(const uint8_t* in, uint8_t texels[16][4], int channel) {
+        int palette[8];
+        channelPalette(in[0], in[1], palette);
+        uint64_t indices = 0;
+        for (int b = 0; b < 6; b++)
+            indices |= (uint64_t)in[2 + b] << (8 * b);
+        for (int i = 0; i < 16; i++)
+            texels[i][channel] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+    }
+
+    // ---- images ----
+
+    long long TextureCompressor::Image::bytes() const {
+        long long total = 0;
+        for (const Level& l : levels)
+            total += (long long)l.data.size();
+        return total;
+    }
+
+    int TextureCompressor::blockBytes(Format format) {
+        return (format == Format::BC1 || format == Format::BC4) ? 8 : 16;
+    }
+
+    long long TextureCompressor::levelBytes(Format format, int width, int height) {
+        return (long long)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+    }
+
+    const char* TextureCompressor::name(Format format) {
+        switch (format) {
+        case Format::BC1: return "BC1";
+        case Format::BC3: return "BC3";
+        case Format::BC4: return "BC4";
+        case Format::BC5: return "BC5";
+        }
+        return "?";
+    }
+
+    GLenum TextureCompressor::glInternalFormat(Format format, bool srgb) {
+        switch (format) {
+        case Format::BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case Format::BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case Format::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case Format::BC5: return GL_COMPRESSED_RG_RGTC2;
+        }
+        return GL_NONE;
+    }
+
+    bool TextureCompressor::supported(Format format, bool srgb) {
+        struct Extensions {
+            bool s3tc = false;
+            bool s3tcSrgb = false;
+
+            Extensions() {
+                GLint count = 0;
+                glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+                for (GLint i = 0; i < count; i++) {
+                    const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+                    if (!name) continue;
+                    if (!std::strcmp(name, "GL_EXT_texture_compression_s3tc")) s3tc = true;
+                    if (!std::strcmp(name, "GL_EXT_texture_sRGB") || !std::strcmp(name, "GL_EXT_texture_compression_s3tc_srgb"))
+                        s3tcSrgb = true;
+                }
+            }
+        };
+        static const Extensions extensions;
+
+        // RGTC (BC4/BC5) is core since GL 3.0
+        if (format == Format::BC4 || format == Format::BC5)
+            return true;
+        return extensions.s3tc && (!srgb || extensions.s3tcSrgb);
+    }
+
+    TextureCompressor::Format TextureCompressor::choose(const uint8_t* rgba, int width, int height, bool color) {
+        bool opaque = true, grey = true, noBlue = true;
+        size_t texels = (size_t)width * height;
+        for (size_t i = 0; i < texels; i++, rgba += 4) {
+            opaque = opaque && rgba[3] == 255;
+            grey = grey && rgba[0] == rgba[1] && rgba[1] == rgba[2];
+            noBlue = noBlue && rgba[2] == 0;
+        }
+
+        if (color)
+            return opaque ? Format::BC1 : Format::BC3;
+        if (grey)
+            return Format::BC4;
+        return noBlue ? Format::BC5 : Format::BC1;
+    }
+
+    void TextureCompressor::compressLevel(const uint8_t* rgba, int width, int height, Format format, uint8_t* out, JobSystem* jobs) {
+        int blocksX = (width + 3) / 4;
+        int blocksY = (height + 3) / 4;
+        int bytes = blockBytes(format);
+
+        auto rows = [&](int firstRow, int lastRow) {
+            uint8_t texels[16][4];
+            for (int by = firstRow; by < lastRow; by++) {
+                for (int bx = 0; bx < blocksX; bx++) {
+                    // edge blocks repeat the last row / column
+                    for (int y = 0; y < 4; y++) {
+                        int sy = std::min(by * 4 + y, height - 1);
+                        for (int x = 0; x < 4; x++) {
+                            int sx = std::min(bx * 4 + x, width - 1);
+                            std::memcpy(texels[y * 4 + x], rgba + ((size_t)sy * width + sx) * 4, 4);
+                        }
+                    }
+
+                    uint8_t* block = out + ((size_t)by * blocksX + bx) * bytes;
+                    switch (format) {
+                    case Format::BC1:
+                        encodeColorBlock(texels, block);
+                        break;
+                    case Format::BC3:
+                        encodeChannelBlock(texels, 3, block);
+                        encodeColorBlock(texels, block + 8);
+                        break;
+                    case Format::BC4:
+                        encodeChannelBlock(texels, 0, block);
+                        break;
+                    case Format::BC5:
+                        encodeChannelBlock(texels, 0, block);
+                        encodeChannelBlock(texels, 1, block + 8);
+                        break;
+                    }
+                }
+            }
+        };
+
+        // about a thousand blocks per job
+        int grain = std::max(1, 1024 / blocksX);
+        if (jobs)
+            jobs->parallelFor(0, blocksY, grain, rows);
+        else
+            rows(0, blocksY);
+    }
+
+    TextureCompressor::Image TextureCompressor::compress(const uint8_t* rgba, int width, int height, Format format, bool srgb, JobSystem* jobs) {
+        PROFILE_ZONE("TextureCompressor::compress");
+        Image image;
+        image.format = format;
+        image.srgb = srgb;
+
+        std::vector<uint8_t> current, next;
+        const uint8_t* level = rgba;
+        while (true) {
+            Level l;
+            l.width = width;
+            l.height = height;
+            l.data.resize((size_t)levelBytes(format, width, height));
+            compressLevel(level, width, height, format, l.data.data(), jobs);
+            image.levels.push_back(std::move(l));
+
+            if (width == 1 && height == 1)
+                break;
+            MipGenerator::downsample(level, width, height, srgb, next, jobs);
+            current.swap(next);
+            level = current.data();
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return image;
+    }
+
+    std::vector<uint8_t> TextureCompressor::decompress(const Level& level, Format format) {
+        std::vector<uint8_t> rgba((size_t)level.width * level.height * 4);
+        int blocksX = (level.width + 3) / 4;
+        int blocksY = (level.height + 3) / 4;
+        int bytes = blockBytes(format);
+
+        for (int by = 0; by < blocksY; by++) {
+            for (int bx = 0; bx < blocksX; bx++) {
+                const uint8_t* block = level.data.data() + ((size_t)by * blocksX + bx) * bytes;
+                uint8_t texels[16][4];
+                std::memset(texels, 0, sizeof(texels));
+                switch (format) {
+                case Format::BC1:
+                    decodeColorBlock(block, texels, true);
+                    break;
+                case Format::BC3:
+                    decodeColorBlock(block + 8, texels, false);
+                    decodeChannelBlock(block, texels, 3);
+                    break;
+                case Format::BC4:
+                    decodeChannelBlock(block, texels, 0);
+                    for (int i = 0; i < 16; i++) texels[i][3] = 255;
+                    break;
+                case Format::BC5:
+                    decodeChannelBlock(block, texels, 0);
+                    decodeChannelBlock(block + 8, texels, 1);
+                    for (int i = 0; i < 16; i++) texels[i][3] = 255;
+                    break;
+                }
+
+                for (int y = 0; y < 4 && by * 4 + y < level.height; y++)
+                    for (int x = 0; x < 4 && bx * 4 + x < level.width; x++)
+                        std::memcpy(rgba.data() + ((size_t)(by * 4 + y) * level.width + bx * 4 + x) * 4, texels[y * 4 + x], 4);
+            }
+        }
+        return rgba;
+    }
+
+    void TextureCompressor::benchmark(const std::string& fileName, int maxThreads) {
+        typedef std::chrono::steady_clock clock;
+        auto ms = [](clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        };
+
+        int width, height, n;
+        auto start = clock::now();
+        unsigned char* rgba = stbi_load(fileName.c_str(), &width, &height, &n, 4);
+        double decodeMs = ms(start);
+        if (!rgba) {
+            std::cout << "ERROR: could not load " << fileName << std::endl;
+            return;
+        }
+
+        long long rawBytes = 0;
+        for (int w = width, h = height; ; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+            rawBytes += (long long)w * h * 4;
+            if (w == 1 && h == 1) break;
+        }
+        std::cout << "Texture compression: " << fileName << " " << width << "x" << height
+            << ", decode " << decodeMs << " ms, RGBA8 with mips " << rawBytes / 1024 << " KB" << std::endl;
+
+        JobSystem jobs;
+        jobs.start(maxThreads - 1);
+
+        const Format formats[] = { Format::BC1, Format::BC3, Format::BC4, Format::BC5 };
+        const int channels[] = { 3, 4, 1, 2 };
+        for (int f = 0; f < 4; f++) {
+            start = clock::now();
+            Image single = compress(rgba, width, height, formats[f], f < 2, nullptr);
+            double singleMs = ms(start);
+            start = clock::now();
+            Image parallel = compress(rgba, width, height, formats[f], f < 2, &jobs);
+            double parallelMs = ms(start);
+
+            // error of level 0 over the channels the format keeps
+            std::vector<uint8_t> decoded = decompress(parallel.levels[0], formats[f]);
+            double sum = 0.0;
+            size_t texels = (size_t)width * height;
+            for (size_t i = 0; i < texels; i++) {
+                for (int k = 0; k < channels[f]; k++) {
+                    double d = (double)decoded[4 * i + k] - rgba[4 * i + k];
+                    sum += d * d;
+                }
+            }
+            double rmse = std::sqrt(sum / (texels * channels[f]));
+            double psnr = rmse > 0.0 ? 20.0 * std::log10(255.0 / rmse) : 99.0;
+            bool same = true;
+            for (size_t l = 0; l < single.levels.size(); l++)
+                same = same && single.levels[l].data == parallel.levels[l].data;
+
+            std::cout << "  " << name(formats[f]) << ": " << parallel.bytes() / 1024 << " KB ("
+                << (double)rawBytes / parallel.bytes() << "x smaller), " << singleMs << " ms on 1 thread, "
+                << parallelMs << " ms on " << jobs.threadCount() << ", PSNR " << psnr << " dB"
+                << (same ? "" : ", differs from the 1 thread result") << std::endl;
+        }
+
+        stbi_image_free(rgba);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef TextureCompressor_hpp
+#define TextureCompressor_hpp
+
+#if defined (__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#define GLEW_STATIC
+#include <GL/glew.h>
+#endif
+
+#include "JobSystem.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gps {
+
+    // CPU encoder for the 4x4 block formats every desktop GL 4.1 driver samples:
+    // BC1 (opaque colour), BC3 (colour + alpha), BC4 (one channel), BC5 (two channels).
+    // Endpoints come from the principal axis of each block and are refined once by
+    // least squares; 4-8x smaller than RGBA8 and decoded by the texture units for free.
+    class TextureCompressor {
+
+    public:
+        enum class Format { BC1, BC3, BC4, BC5 };
+
+        struct Level {
+            int width = 0;
+            int height = 0;
+            std::vector<uint8_t> data;
+        };
+
+        // a compressed texture with its whole mip chain, level 0 first
+        struct Image {
+            Format format = Format::BC1;
+            bool srgb = true;
+            std::vector<Level> levels;
+
+            int width() const { return levels.empty() ? 0 : levels[0].width; }
+            int height() const { return levels.empty() ? 0 : levels[0].height; }
+            long long bytes() const;
+        };
+
+        // colour: BC1, or BC3 when some texel is not opaque. Masks: BC4 when grey,
+        // BC5 when blue carries nothing, otherwise BC1 without sRGB
+        static Format choose(const uint8_t* rgba, int width, int height, bool color);
+
+        // rgba rows in upload order; builds the mip chain (MipGenerator) and compresses every level,
+        // rows of blocks in parallel when jobs is set
+        static Image compress(const uint8_t* rgba, int width, int height, Format format, bool srgb, JobSystem* jobs);
+        static void compressLevel(const uint8_t* rgba, int width, int height, Format format, uint8_t* out, JobSystem* jobs);
+
+        // back to RGBA8 (error measurements)
+        static std::vector<uint8_t> decompress(const Level& level, Format format);
+
+        static int blockBytes(Format format);
+        static long long levelBytes(Format format, int width, int height);
+        static const char* name(Format format);
+
+        static GLenum glInternalFormat(Format format, bool srgb);
+        // whether the current context samples the format (S3TC is an extension)
+        static bool supported(Format format, bool srgb);
+
+        // decode, mip and compress times, sizes and error of each format for one image
+        static void benchmark(const std::string& fileName, int maxThreads);
+    };
+}
+
+#endif /* TextureCompressor_hpp */
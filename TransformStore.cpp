@@ -0,0 +1,208 @@
+#include "TransformStore.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace gps {
+
+    const TransformId TransformStore::NONE;
+
+    static bool sameRotation(const glm::quat& a, const glm::quat& b) {
+        return a.w == b.w && a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    TransformId TransformStore::create(const glm::vec3& position, const glm::quat& rotation, float scale,
+        TransformId parent) {
+
+        TransformId id = (TransformId)positions.size();
+        positions.push_back(position);
+        rotations.push_back(rotation);
+        scales.push_back(scale);
+        parents.push_back(parent < id ? parent : NONE);
+        flags.push_back(DIRTY);
+
+        worlds.push_back(glm::mat4(1.0f));
+        normals.push_back(glm::mat3(1.0f));
+        worldScales.push_back(1.0f);
+
+        dirtyCount++;
+        return id;
+    }
+
+    void TransformStore::clear() {
+        positions.clear();
+        rotations.clear();
+        scales.clear();
+        parents.clear();
+        flags.clear();
+        worlds.clear();
+        normals.clear();
+        worldScales.clear();
+        dirtyCount = 0;
+    }
+
+    void TransformStore::markDirty(TransformId id) {
+        if (!(flags[id] & DIRTY)) {
+            flags[id] |= DIRTY;
+            dirtyCount++;
+        }
+    }
+
+    void TransformStore::setPosition(TransformId id, const glm::vec3& position) {
+        if (positions[id] == position) return;
+        positions[id] = position;
+        markDirty(id);
+    }
+
+    void TransformStore::setRotation(TransformId id, const glm::quat& rotation) {
+        if (sameRotation(rotations[id], rotation)) return;
+        rotations[id] = rotation;
+        markDirty(id);
+    }
+
+    void TransformStore::setScale(TransformId id, float scale) {
+        if (scales[id] == scale) return;
+        scales[id] = scale;
+        markDirty(id);
+    }
+
+    void TransformStore::setLocal(TransformId id, const glm::vec3& position, const glm::quat& rotation, float scale) {
+        setPosition(id, position);
+        setRotation(id, rotation);
+        setScale(id, scale);
+    }
+
+    int TransformStore::update() {
+        if (dirtyCount == 0)
+            return 0;
+
+        int rebuilt = 0;
+        const size_t n = positions.size();
+
+        for (size_t i = 0; i < n; i++) {
+            TransformId p = parents[i];
+
+            // UPDATED marks objects rebuilt in this pass; parents come first,
+            // so their flag is already current when a child looks at it
+            bool rebuild = (flags[i] & DIRTY) || (p != NONE && (flags[p] & UPDATED));
+            flags[i] = rebuild ? UPDATED : 0;
+            if (!rebuild) continue;
+
+            float s = scales[i];
+            glm::mat3 r = glm::mat3_cast(rotations[i]);
+            glm::mat4 local(
+                glm::vec4(r[0] * s, 0.0f),
+                glm::vec4(r[1] * s, 0.0f),
+                glm::vec4(r[2] * s, 0.0f),
+                glm::vec4(positions[i], 1.0f));
+
+            if (p == NONE) {
+                worlds[i] = local;
+                worldScales[i] = s;
+            }
+            else {
+                worlds[i] = worlds[p] * local;
+                worldScales[i] = worldScales[p] * s;
+            }
+
+            // rotation * uniform scale: the inverse transpose is the same matrix over scale^2
+            float ws = worldScales[i];
+            normals[i] = glm::mat3(worlds[i]) * (1.0f / (ws * ws));
+            rebuilt++;
+        }
+
+        dirtyCount = 0;
+        return rebuilt;
+    }
+
+    glm::quat TransformStore::fromEulerDegrees(const glm::vec3& degrees) {
+        return glm::angleAxis(glm::radians(degrees.y), glm::vec3(0, 1, 0))
+            * glm::angleAxis(glm::radians(degrees.x), glm::vec3(1, 0, 0))
+            * glm::angleAxis(glm::radians(degrees.z), glm::vec3(0, 0, 1));
+    }
+
+    void TransformStore::benchmark(int objectCount, int frames) {
+        typedef std::chrono::steady_clock clock;
+        auto usPerFrame = [frames](clock::time_point start) {
+            return std::chrono::duration<double, std::micro>(clock::now() - start).count() / frames;
+        };
+
+        // every 8th object is a root, the rest hang off the previous object
+        std::vector<glm::vec3> pos(objectCount), rot(objectCount);
+        std::vector<float> scl(objectCount);
+        TransformStore store;
+        srand(7);
+        for (int i = 0; i < objectCount; i++) {
+            pos[i] = glm::vec3(rand() % 100 * 0.1f, rand() % 100 * 0.1f, rand() % 100 * 0.1f);
+            rot[i] = glm::vec3((float)(rand() % 360), (float)(rand() % 360), (float)(rand() % 360));
+            scl[i] = 0.5f + rand() % 100 * 0.01f;
+            store.create(pos[i], fromEulerDegrees(rot[i]), scl[i], i % 8 == 0 ? NONE : (TransformId)(i - 1));
+        }
+        store.update();
+
+        glm::mat4 view = glm::lookAt(glm::vec3(0, 2, 8), glm::vec3(0), glm::vec3(0, 1, 0));
+        glm::mat3 viewRotation = glm::mat3(view);
+        volatile float sink = 0.0f;
+
+        std::cout << "Transforms: " << objectCount << " objects (chains of 8), " << frames << " frames" << std::endl;
+
+        // 1. what main.cpp did: Euler matrices and an inverse per object, every frame
+        std::vector<glm::mat4> eulerWorld(objectCount);
+        auto start = clock::now();
+        for (int f = 0; f < frames; f++) {
+            for (int i = 0; i < objectCount; i++) {
+                glm::mat4 m(1.0f);
+                m = glm::translate(m, pos[i]);
+                m = glm::rotate(m, glm::radians(rot[i].y), glm::vec3(0, 1, 0));
+                m = glm::rotate(m, glm::radians(rot[i].x), glm::vec3(1, 0, 0));
+                m = glm::rotate(m, glm::radians(rot[i].z), glm::vec3(0, 0, 1));
+                m = glm::scale(m, glm::vec3(scl[i]));
+                eulerWorld[i] = i % 8 == 0 ? m : eulerWorld[i - 1] * m;
+                glm::mat3 normalMatrix = glm::mat3(glm::inverseTranspose(view * eulerWorld[i]));
+                sink = sink + normalMatrix[0][0];
+            }
+        }
+        std::cout << "  Euler rebuild + inverseTranspose: " << usPerFrame(start) << " us/frame" << std::endl;
+
+        // 2. 1% and then all of the roots move every frame, their chains follow
+        for (int percent : { 1, 100 }) {
+            int step = 100 / percent;
+            int rebuilt = 0;
+            start = clock::now();
+            for (int f = 0; f < frames; f++) {
+                for (int i = f % step * 8 % objectCount; i < objectCount; i += step * 8)
+                    store.setPosition((TransformId)i, pos[i] + glm::vec3(0.0f, 0.001f * (f + 1), 0.0f));
+                rebuilt += store.update();
+                for (int i = 0; i < objectCount; i++)
+                    sink = sink + (viewRotation * store.normalMatrix((TransformId)i))[0][0];
+            }
+            std::cout << "  store, " << percent << "% of roots moving: " << usPerFrame(start) << " us/frame ("
+                << rebuilt / frames << " matrices rebuilt per frame)" << std::endl;
+        }
+
+        // the cached matrices must match the Euler path
+        for (int i = 0; i < objectCount; i++)
+            store.setPosition((TransformId)i, pos[i]);
+        store.update();
+
+        float maxError = 0.0f;
+        for (int i = 0; i < objectCount; i++) {
+            const glm::mat4& a = store.world((TransformId)i);
+            glm::mat3 na = viewRotation * store.normalMatrix((TransformId)i);
+            glm::mat3 nb = glm::mat3(glm::inverseTranspose(view * eulerWorld[i]));
+            for (int c = 0; c < 3; c++) {
+                glm::vec3 dw = glm::vec3(a[c]) - glm::vec3(eulerWorld[i][c]);
+                glm::vec3 dn = na[c] - nb[c];
+                float scaleRef = glm::length(glm::vec3(eulerWorld[i][c])) + glm::length(nb[c]);
+                maxError = std::max(maxError, (glm::length(dw) + glm::length(dn)) / scaleRef);
+            }
+        }
+        std::cout << "  max relative difference to the Euler path: " << maxError << std::endl;
+    }
+}
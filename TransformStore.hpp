@@ -0,0 +1,73 @@
+#ifndef TransformStore_hpp
+#define TransformStore_hpp
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace gps {
+
+    typedef uint32_t TransformId;
+
+    // structure-of-arrays storage for object transforms (position, rotation,
+    // uniform scale) with parent/child links. World and normal matrices are
+    // cached and only rebuilt by update() for objects that changed, or whose
+    // parent did. Parents are always created before their children, so one
+    // forward pass over the arrays resolves the whole hierarchy.
+    class TransformStore {
+
+    public:
+        static const TransformId NONE = 0xffffffffu;
+
+        TransformId create(const glm::vec3& position, const glm::quat& rotation, float scale,
+            TransformId parent = NONE);
+        void clear();
+        size_t size() const { return positions.size(); }
+
+        // setters only mark the object dirty when the value really changes
+        void setPosition(TransformId id, const glm::vec3& position);
+        void setRotation(TransformId id, const glm::quat& rotation);
+        void setScale(TransformId id, float scale);
+        void setLocal(TransformId id, const glm::vec3& position, const glm::quat& rotation, float scale);
+
+        const glm::vec3& position(TransformId id) const { return positions[id]; }
+        const glm::quat& rotation(TransformId id) const { return rotations[id]; }
+        float scale(TransformId id) const { return scales[id]; }
+        TransformId parent(TransformId id) const { return parents[id]; }
+
+        // rebuilds dirty world / normal matrices; returns how many were rebuilt
+        int update();
+
+        // valid after update()
+        const glm::mat4& world(TransformId id) const { return worlds[id]; }
+        // inverse transpose of the world 3x3; view space normals are mat3(view) * normalMatrix
+        const glm::mat3& normalMatrix(TransformId id) const { return normals[id]; }
+
+        // rotation order of the old composeModelMatrix: yaw (Y), then pitch (X), then roll (Z)
+        static glm::quat fromEulerDegrees(const glm::vec3& degrees);
+
+        // per-frame Euler rebuild + inverse vs cached update with few / all objects dirty
+        static void benchmark(int objectCount, int frames);
+
+    private:
+        enum : uint8_t { DIRTY = 1, UPDATED = 2 };
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::quat> rotations;
+        std::vector<float> scales;
+        std::vector<TransformId> parents;
+        std::vector<uint8_t> flags;
+
+        std::vector<glm::mat4> worlds;
+        std::vector<glm::mat3> normals;
+        std::vector<float> worldScales;
+
+        int dirtyCount = 0;
+
+        void markDirty(TransformId id);
+    };
+}
+
+#endif /* TransformStore_hpp */
@@ -0,0 +1,42 @@
+#ifndef TripleBuffer_hpp
+#define TripleBuffer_hpp
+
+#include <atomic>
+
+namespace gps {
+
+    // lock-free single producer / single consumer hand-off of the latest value.
+    // The producer writes back() and publish()es it; the consumer acquire()s the
+    // newest published value and reads front(). Neither side ever waits, and a
+    // value the consumer did not pick up in time is simply replaced.
+    template <typename T>
+    class TripleBuffer {
+
+    public:
+        // producer side
+        T& back() { return buffers[backIndex]; }
+        void publish() {
+            backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        // consumer side; returns false (and keeps front()) when nothing new was published
+        bool acquire() {
+            if (!(middle.load(std::memory_order_acquire) & FRESH))
+                return false;
+            frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+        const T& front() const { return buffers[frontIndex]; }
+
+    private:
+        static const int INDEX_MASK = 3;
+        static const int FRESH = 4;
+
+        T buffers[3] = {};
+        int backIndex = 0;
+        int frontIndex = 1;
+        std::atomic<int> middle{ 2 };
+    };
+}
+
+#endif /* TripleBuffer_hpp */
@@ -1,8 +1,17 @@
 #include "Window.h"
+#include "ResourceTracker.hpp"
 
 namespace gps {
 
-    void Window::Create(int width, int height, const char *title) {
+    void Window::Create(int width, int height, const char *title, bool headless) {
+        this->headless = headless;
+
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+        // no display server needed: the null platform only creates the context
+        if (headless)
+            glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
         if (!glfwInit()) {
             throw std::runtime_error("Could not start GLFW3!");
         }
@@ -22,14 +31,26 @@ namespace gps {
         //for antialising
         glfwWindowHint(GLFW_SAMPLES, 4);
 
+        if (headless) {
+            // the offscreen FBO is single-sampled; the hidden default framebuffer is never shown
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            glfwWindowHint(GLFW_SAMPLES, 0);
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        }
+
         this->window = glfwCreateWindow(width, height, title, NULL, NULL);
+        if (!this->window && headless) {
+            // no EGL driver: software OSMesa (llvmpipe) context
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+            this->window = glfwCreateWindow(width, height, title, NULL, NULL);
+        }
         if (!this->window) {
-            throw std::runtime_error("Could not create GLFW3 window!");
+            throw std::runtime_error(headless ? "Could not create a headless GL context!" : "Could not create GLFW3 window!");
         }
 
         glfwMakeContextCurrent(window);
 
-        glfwSwapInterval(1);
+        setVSync(!headless);
 
 #if not defined (__APPLE__)
         // start GLEW extension handler
@@ -45,9 +66,57 @@ namespace gps {
 
         //for RETINA display
         glfwGetFramebufferSize(window, &this->dimensions.width, &this->dimensions.height);
+
+        if (headless) {
+            this->dimensions.width = width;
+            this->dimensions.height = height;
+            createOffscreenTarget();
+        }
+    }
+
+    void Window::createOffscreenTarget() {
+        int width = dimensions.width;
+        int height = dimensions.height;
+
+        // sRGB colour like the window's default framebuffer, so GL_FRAMEBUFFER_SRGB behaves the same
+        glGenTextures(1, &offscreenColor);
+        glBindTexture(GL_TEXTURE_2D, offscreenColor);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenRenderbuffers(1, &offscreenDepth);
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        ResourceTracker::add(ResourceTracker::Kind::Texture, offscreenColor, "window", "offscreen target", 4LL * width * height);
+        ResourceTracker::add(ResourceTracker::Kind::Renderbuffer, offscreenDepth, "window", "offscreen target", 4LL * width * height);
+
+        glGenFramebuffers(1, &offscreenFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, offscreenFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, offscreenColor, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreenDepth);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            throw std::runtime_error("Headless framebuffer incomplete!");
+        }
+        std::cout << "Headless: rendering to a " << width << "x" << height << " offscreen framebuffer" << std::endl;
+    }
+
+    void Window::setVSync(bool enabled) {
+        glfwSwapInterval(enabled ? 1 : 0);
     }
 
     void Window::Delete() {
+        ResourceTracker::remove(ResourceTracker::Kind::Texture, offscreenColor);
+        ResourceTracker::remove(ResourceTracker::Kind::Renderbuffer, offscreenDepth);
+        if (offscreenFBO) glDeleteFramebuffers(1, &offscreenFBO);
+        if (offscreenColor) glDeleteTextures(1, &offscreenColor);
+        if (offscreenDepth) glDeleteRenderbuffers(1, &offscreenDepth);
+        offscreenFBO = offscreenColor = offscreenDepth = 0;
+
         if (window)
             glfwDestroyWindow(window);
         //close GL context and any other GLFW resources
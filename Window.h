@@ -24,16 +24,30 @@ namespace gps {
     class Window {
 
     public:
-        void Create(int width=800, int height=600, const char *title="OpenGL Project");
+        // headless: no visible window (GLFW null platform with an EGL or OSMesa
+        // context where available), vsync off, rendering goes to an offscreen FBO
+        void Create(int width=800, int height=600, const char *title="OpenGL Project", bool headless=false);
         void Delete();
 
         GLFWwindow* getWindow();
         WindowDimensions getWindowDimensions();
         void setWindowDimensions(WindowDimensions dimensions);
 
+        bool isHeadless() const { return headless; }
+        void setVSync(bool enabled);
+        // where the final image is drawn: 0 for a window, the offscreen FBO when headless
+        GLuint getFramebuffer() const { return offscreenFBO; }
+
     private:
         WindowDimensions dimensions;
-        GLFWwindow *window;
+        GLFWwindow *window = nullptr;
+
+        bool headless = false;
+        GLuint offscreenFBO = 0;
+        GLuint offscreenColor = 0;
+        GLuint offscreenDepth = 0;
+
+        void createOffscreenTarget();
     };
 }
 
@@ -17,14 +17,88 @@
 #include "Shader.hpp"
 #include "Camera.hpp"
 #include "Model3D.hpp"
+#include "Collision.hpp"
+#include "ModelColliders.hpp"
+#include "BVH.hpp"
+#include "Scene.hpp"
+#include "TransformStore.hpp"
+#include "Benchmark.hpp"
+#include "GpuProfiler.hpp"
+#include "Profiler.hpp"
+#include "Hud.hpp"
+#include "FrameCapture.hpp"
+#include "ImageWriter.hpp"
+#include "ImageCompare.hpp"
+#include "ResourceTracker.hpp"
+#include "TextureCache.hpp"
+#include "MipGenerator.hpp"
+#include "TripleBuffer.hpp"
+#include "ParticleSystem.hpp"
+#include "JobSystem.hpp"
+#include "GpuParticleSystem.hpp"
+#include "RadixSort.hpp"
 
 #include <iostream>
 #include <cmath>
 #include <vector>   
+#include <string>
+#include <algorithm>
 #include <ctime>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+
+// counts the GL calls below; keep it the last include
+#include "GLStatsHooks.hpp"
 
 // window
 gps::Window myWindow;
+// offscreen rendering without a display, for build machines
+bool headless = false;
+// stop after this many frames (0 = until the window closes)
+int frameLimit = 0;
+
+// --benchmark: replays the presentation path with a simulated clock that
+// advances BENCHMARK_FRAME_TIME per frame, so every run renders the same frames
+int benchmarkFrames = 0;
+std::string benchmarkCsv = "benchmark.csv";
+static const double BENCHMARK_FRAME_TIME = 1.0 / 60.0;
+double benchmarkClock = 0.0;
+gps::BenchmarkRecorder benchmarkRecorder;
+
+// GPU time per render pass (--gpu-passes logs it, --benchmark records it)
+gps::GpuProfiler gpuProfiler;
+bool gpuPassLog = false;
+static const int gpuPassLogFrames = 120;
+
+// frame statistics overlay (F4, --hud)
+gps::Hud hud;
+
+// screenshots (F12) and frame sequences (shift+F12, --capture) read back without stalling
+gps::FrameCapture frameCapture;
+std::string capturePrefix;
+gps::FrameCapture::Format captureFormat = gps::FrameCapture::Format::Png;
+
+// CPU zone traces (Chrome trace JSON): start-up until the first frame, and/or a frame range
+std::string traceStartupFile;
+std::string traceFramesFile;
+int traceFirstFrame = 0;
+int traceFrameCount = 0;
+
+// --golden: renders every camera path point headless and compares it with
+// <dir>/view_NN.png; --golden-update writes those references instead
+std::string goldenDir;
+bool goldenUpdate = false;
+double goldenTolerance = 0.01; // fraction of pixels allowed to differ noticeably
+static const int GOLDEN_TIMED_FRAMES = 10;
+
+// wall clock, or the simulated clock while benchmarking (it stays at 0 for --golden)
+static double frameClock()
+{
+    return benchmarkFrames > 0 || !goldenDir.empty() ? benchmarkClock : glfwGetTime();
+}
 
 // matrices
 glm::mat4 view;
@@ -68,20 +142,67 @@ static const unsigned int SHADOW_WIDTH = 2048;
 static const unsigned int SHADOW_HEIGHT = 2048;
 
 
-// camera
+// camera (placed by the scene file)
 gps::Camera myCamera(
-    glm::vec3(2.0f, 2.0f, 8.0f),                    // position
-    glm::vec3(3.4273f, 0.800309f, 6.92084f),        // target (pug)
+    glm::vec3(0.0f, 2.0f, 5.0f),
+    glm::vec3(0.0f),
     glm::vec3(0.0f, 1.0f, 0.0f)
 );
 
 float cameraSpeed = 2.5f; 
-bool pressedKeys[1024];
+// written by the GLFW callbacks, read by the simulation thread
+std::atomic<bool> pressedKeys[1024];
 
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// fixed-step simulation: movement, collisions and animation advance in SIM_STEP
+// increments, rendering interpolates between the last two steps
+float simStep = 1.0f / 120.0f;
+static const int MAX_SIM_STEPS = 8;
+static const float MAX_FRAME_TIME = 0.25f;
+float simAccumulator = 0.0f;
+
+struct SimSnapshot {
+    glm::vec3 cameraPos;
+    glm::vec3 lookTarget;    // presentation mode only
+    float time;
+    float sakuraTime;
+};
+SimSnapshot simPrevious = {};
+SimSnapshot simCurrent = {};
+
+// everything the render thread needs from the simulation, published after each
+// batch of steps; the render thread only ever reads the latest one
+struct FrameState {
+    SimSnapshot previous;
+    SimSnapshot current;
+    double stepTime;         // wall clock time that current corresponds to
+
+    glm::vec3 cameraFront;
+    glm::vec3 cameraUp;
+    bool presentation;
+
+    glm::vec3 gardenPos, gardenRot;
+    float gardenScale;
+    glm::vec3 pugPos, pugRot;
+    float pugScale;
+
+    glm::vec3 lightDir;
+};
+gps::TripleBuffer<FrameState> frameStates;
+
+// simulation thread (--single-thread runs the steps on the render thread instead)
+std::thread simThread;
+std::atomic<bool> simRunning(false);
+bool singleThreaded = false;
+
+// input handed from the callbacks to the simulation
+std::mutex lookMutex;
+glm::vec2 pendingLook(0.0f);   // pitch, yaw in degrees
+std::atomic<bool> presentationToggle(false);
+
 // mouse look
 bool firstMouse = true;
 double lastX = 512.0, lastY = 384.0;
@@ -96,10 +217,29 @@ bool presentationMode = false;
 float presentationRadius = 10.0f;
 glm::vec3 presentationTarget = glm::vec3(0.0f, 1.0f, 0.0f);
 
+// scene description: models, lights, emitters, colliders and camera path
+gps::Scene scene;
+std::string scenePath = "resources/scenes/garden.scene";
+
 // models
 gps::Model3D garden;
 gps::Model3D pug;
 
+// scene models other than garden/pug, drawn as static props
+std::vector<std::unique_ptr<gps::Model3D>> props;
+std::vector<gps::TransformId> propTransforms;
+// loaded model and transform for every scene.models entry
+std::vector<gps::Model3D*> sceneModels;
+std::vector<gps::TransformId> sceneTransforms;
+
+// world / normal matrices of everything drawn, rebuilt only when an object moves
+gps::TransformStore transforms;
+// the simulation thread's copy for collider generation; the render thread animates transforms
+gps::TransformStore colliderTransforms;
+bool collidersStale = false;
+gps::TransformId gardenTransform = gps::TransformStore::NONE;
+gps::TransformId pugTransform = gps::TransformStore::NONE;
+
 // per-object transforms
 glm::vec3 gardenPos(0.0f, 0.0f, 0.0f);
 glm::vec3 gardenRot(0.0f, 0.0f, 0.0f); // degrees
@@ -108,40 +248,43 @@ float gardenScale = 1.0f;
 glm::vec3 pugPos(0.0f, 0.0f, 0.0f);
 glm::vec3 pugRot(0.0f, 0.0f, 0.0f); // degrees
 float pugScale = 1.0f;
-//garden lamps
-glm::vec3 lampPosA(6.5167f, 2.00031f, 7.46291f);
-glm::vec3 lampPosB(13.4391f, 2.00031f, 9.7713f);
-
-glm::vec3 lampColor(2.0f, 1.55f, 1.05f); // warm lantern light
+//garden lamps, blended into one point light
+glm::vec3 lampPos(0.0f);
+glm::vec3 lampColor(0.0f);
 bool lampsEnabled = true;
 
 // which object is controlled
 enum class SelectedObject { Garden, Pug };
-SelectedObject selected = SelectedObject::Garden;
+std::atomic<SelectedObject> selected(SelectedObject::Garden);
 bool enterPressed = false;
 
 // shaders
 gps::Shader myBasicShader;
 
-struct AABB {
-    glm::vec3 min;
-    glm::vec3 max;
-};
-
-static std::vector<AABB> colliders;
+// hand-placed boxes (also used by the petals) + boxes derived from garden.obj
+static std::vector<gps::AABB> colliders;
+static gps::ColliderGrid colliderGrid;
+static bool autoColliders = true;
 
 // player body radius (camera collision)
 static const float playerRadius = 0.35f;
 
-static const float gardenMinX = -4.6f;
-static const float gardenMaxX = 16.1f;
+// walkable area (from the scene bounds)
+static float gardenMinX = -4.6f;
+static float gardenMaxX = 16.1f;
 
-static const float gardenMinZ = -3.6f;
-static const float gardenMaxZ = 19.76f;
+static float gardenMinZ = -3.6f;
+static float gardenMaxZ = 19.76f;
 
 // floor & ceiling
-static const float groundMinY = 0.75f;
-static const float ceilingMaxY = 3.8f;
+static float groundMinY = 0.75f;
+static float ceilingMaxY = 3.8f;
+
+// ground following: eye height above the garden triangles under the player
+static gps::TriangleBVH groundBVH;
+static const float eyeHeight = 0.75f;
+// highest ledge the player steps up onto
+static const float stepHeight = 0.45f;
 
 gps::Shader sakuraShader;
 
@@ -152,9 +295,50 @@ std::vector<glm::vec3> sakuraPositions;
 std::vector<float> sakuraSeeds;
 
 float sakuraTime = 0.0f;
-glm::vec3 sakuraTreePosA = glm::vec3(15.55f, 7.8f, 3.64f);
-glm::vec3 sakuraTreePosB = glm::vec3(-0.71f, 7.8f, 13.82f);
-glm::vec3 sakuraTreePosC = glm::vec3(15.28f, 7.8f, 16.12f);
+
+// petal rendering: procedural (sakura.vert), CPU-simulated (ParticleSystem)
+// or GPU-simulated with transform feedback (GpuParticleSystem)
+enum class PetalMode { Procedural, Cpu, Gpu };
+PetalMode petalMode = PetalMode::Cpu;
+int cpuPetalCount = 20000;
+int gpuPetalCount = 262144;
+gps::ParticleSystem sakuraParticles;
+gps::GpuParticleSystem gpuSakuraParticles;
+gps::Shader petalShader;
+gps::Shader petalUpdateShader;
+
+// petal transparency: unsorted alpha blending, back-to-front radix sort (CPU petals)
+// or weighted blended OIT (any petal mode)
+enum class PetalBlend { Unsorted, Sorted, WeightedOIT };
+PetalBlend petalBlend = PetalBlend::Unsorted;
+gps::Shader petalOitShader;
+gps::Shader sakuraOitShader;
+gps::Shader oitCompositeShader;
+
+GLuint oitFBO = 0;
+GLuint oitAccumTex = 0;
+GLuint oitRevealTex = 0;
+GLuint oitDepthRBO = 0;
+GLuint oitVAO = 0;
+int oitWidth = 0;
+int oitHeight = 0;
+
+// GPU time of the petal pass, printed every petalTimingFrames when enabled
+bool petalTimingLog = false;
+static const int PETAL_QUERY_COUNT = 3;
+static const int petalTimingFrames = 120;
+GLuint petalQueries[PETAL_QUERY_COUNT] = {};
+bool petalQueryPending[PETAL_QUERY_COUNT] = {};
+int petalQueryFrame = 0;
+double petalGpuMsSum = 0.0;
+int petalGpuSamples = 0;
+
+// shared job system: model loading, culling, petal simulation (0 = hardware threads)
+gps::JobSystem jobSystem;
+int workerThreads = 0;
+static const float petalGroundY = 0.02f;
+// sakura trees the petals fall from; the procedural shader uses the first three
+std::vector<glm::vec3> sakuraTrees;
 
 gps::Shader skyboxShader;
 
@@ -162,22 +346,7 @@ GLuint skyboxVAO = 0;
 GLuint skyboxVBO = 0;
 GLuint cubemapTex = 0;
 
-std::vector<glm::vec3> presentationPoints = {
-    { 0.110114f, 1.40657f, 7.72186f },
-    { -1.15373f, 1.091f, 14.0603f },
-    { 4.72644f, 1.46494f, 14.9234f },
-    { 13.1005f, 1.79564f, 15.469f },
-    { 14.999f, 1.37455f, 8.37873f },
-    { 12.4394f, 1.5763f, 5.5074f },
-    { 7.65837f, 2.25419f, 0.253555f },
-    { 5.50631f, 2.251f, 0.522661f },
-    { 3.74401f, 2.251f, 0.957677f },
-    { 0.959815f, 2.251f, 1.75131f },
-    { 0.375391f, 2.251f, 2.80276f },
-    { -0.179611f, 2.251f, 4.35139f },
-    { 6.49703f, 1.59893f, 15.0376f },
-    { 10.5825f, 0.877511f, 19.3574f }
-};
+std::vector<glm::vec3> presentationPoints;
 
 int presentationIndex = 0;
 float presentationT = 0.0f;
@@ -202,6 +371,7 @@ GLuint loadCubemap(const std::vector<std::string>& faces)
 
     int width, height, nrChannels;
     stbi_set_flip_vertically_on_load(false); 
+    long long bytes = 0;
 
     for (unsigned int i = 0; i < faces.size(); i++)
     {
@@ -212,6 +382,7 @@ GLuint loadCubemap(const std::vector<std::string>& faces)
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
                 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
             stbi_image_free(data);
+            bytes += 4LL * width * height; // RGB is padded to 4 bytes a texel
         }
         else
         {
@@ -227,6 +398,7 @@ GLuint loadCubemap(const std::vector<std::string>& faces)
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    gps::ResourceTracker::add(gps::ResourceTracker::Kind::Texture, textureID, "renderer", "skybox", bytes);
     return textureID;
 }
 
@@ -273,6 +445,7 @@ void toggleFullscreen(GLFWwindow* window)
 
 void initSkybox()
 {
+    PROFILE_ZONE("initSkybox");
     float skyboxVertices[] = {
         // positions
         -1.0f,  1.0f, -1.0f,  -1.0f, -1.0f, -1.0f,   1.0f, -1.0f, -1.0f,
@@ -300,6 +473,7 @@ void initSkybox()
 
     glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
+    gps::ResourceTracker::add(gps::ResourceTracker::Kind::Buffer, skyboxVBO, "renderer", "skybox", sizeof(skyboxVertices));
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -340,61 +514,118 @@ static glm::vec3 clampInsideGarden(const glm::vec3& p)
     return out;
 }
 
-// sphere vs AABB
-static bool sphereIntersectsAABB(const glm::vec3& c, float r, const AABB& b)
+// one camera move against the colliders and the walkable ground
+static glm::vec3 moveCamera(const gps::ColliderGrid& grid, const gps::TriangleBVH& ground,
+    const glm::vec3& previous, const glm::vec3& target)
 {
-    glm::vec3 closest = glm::clamp(c, b.min, b.max);
-    glm::vec3 d = c - closest;
-    return glm::dot(d, d) < (r * r);
+    // sweep from last frame's position so large steps can't skip over thin walls
+    glm::vec3 p = grid.slideSphere(previous, target - previous, playerRadius, 4, &ground);
+
+    // garden bounds (walls + floor + ceiling)
+    p = clampInsideGarden(p);
+
+    // stand on the bridge, steps and house floor instead of the flat groundMinY;
+    // anything higher than a step above the feet is not climbed
+    float groundY;
+    if (ground.groundHeight(p, playerRadius, ceilingMaxY, p.y - eyeHeight + stepHeight, groundY))
+        p.y = glm::clamp(p.y, std::min(groundY + eyeHeight, ceilingMaxY), ceilingMaxY);
+
+    // push out of anything still overlapping (start inside a box, bounds clamp)
+    static std::vector<int> candidates;
+    candidates.clear();
+    grid.querySphere(p, playerRadius, candidates);
+    for (int i : candidates) {
+        const gps::AABB& b = grid.boxes()[i];
+        if (gps::sphereIntersectsAABB(p, playerRadius, b)) {
+            p = gps::resolveSphereAABB(p, playerRadius, b);
+        }
+    }
+
+    return p;
 }
 
-static glm::vec3 resolveSphereAABB(glm::vec3 c, float r, const AABB& b)
+static void solveCameraCollisions(const glm::vec3& previous)
 {
-    glm::vec3 closest = glm::clamp(c, b.min, b.max);
-    glm::vec3 delta = c - closest;
-
-    if (glm::length(delta) < 1e-6f) {
-        float left = c.x - b.min.x;
-        float right = b.max.x - c.x;
-        float down = c.y - b.min.y;
-        float up = b.max.y - c.y;
-        float back = c.z - b.min.z;
-        float front = b.max.z - c.z;
-
-        float m = left; int axis = 0; float sign = -1.0f;
-        if (right < m) { m = right; axis = 0; sign = +1.0f; }
-        if (down < m) { m = down;  axis = 1; sign = -1.0f; }
-        if (up < m) { m = up;    axis = 1; sign = +1.0f; }
-        if (back < m) { m = back;  axis = 2; sign = -1.0f; }
-        if (front < m) { m = front; axis = 2; sign = +1.0f; }
-
-        if (axis == 0) c.x += sign * (r + 0.001f);
-        if (axis == 1) c.y += sign * (r + 0.001f);
-        if (axis == 2) c.z += sign * (r + 0.001f);
-        return c;
-    }
-
-    float dist = glm::length(delta);
-    glm::vec3 n = delta / dist;
-    float push = (r - dist) + 0.001f;
-    return c + n * push;
+    myCamera.setPosition(moveCamera(colliderGrid, groundBVH, previous, myCamera.getPosition()));
 }
 
-static void solveCameraCollisions()
+// walks the camera over a generated arched bridge with railings: the planks must
+// lift it onto the deck, the railings must stop it and a bench beside it must not
+// keep it off the deck (--check-walk)
+static int checkBridgeWalk()
 {
-    glm::vec3 p = myCamera.getPosition();
-
-    // garden bounds (walls + floor + ceiling)
-    p = clampInsideGarden(p);
-
-    // house AABB
-    for (const auto& b : colliders) {
-        if (sphereIntersectsAABB(p, playerRadius, b)) {
-            p = resolveSphereAABB(p, playerRadius, b);
+    std::vector<gps::Triangle> planks, rails, bench, ground;
+    auto addBox = [](std::vector<gps::Triangle>& out, glm::vec3 lo, glm::vec3 hi) {
+        glm::vec3 c[8];
+        for (int i = 0; i < 8; i++)
+            c[i] = glm::vec3(i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z);
+        const int faces[6][4] = { { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 } };
+        for (const auto& f : faces) {
+            out.push_back(gps::Triangle{ c[f[0]], c[f[1]], c[f[2]] });
+            out.push_back(gps::Triangle{ c[f[0]], c[f[2]], c[f[3]] });
         }
-    }
+    };
 
-    myCamera.setPosition(p);
+    // deck from x = 0 to 8 across z = 2..4, rising to 1 m in the middle
+    const float floorY = groundMinY - eyeHeight;
+    auto deckHeight = [&](float x) { return floorY + std::sin(glm::pi<float>() * glm::clamp(x / 8.0f, 0.0f, 1.0f)); };
+    for (int i = 0; i < 16; i++) {
+        float x0 = i * 0.5f, top = deckHeight(x0 + 0.25f);
+        addBox(planks, glm::vec3(x0, top - 0.1f, 2.0f), glm::vec3(x0 + 0.5f, top, 4.0f));
+    }
+    addBox(rails, glm::vec3(0.0f, floorY, 1.9f), glm::vec3(8.0f, floorY + 1.9f, 1.95f));
+    addBox(rails, glm::vec3(0.0f, floorY, 4.05f), glm::vec3(8.0f, floorY + 1.9f, 4.1f));
+    addBox(ground, glm::vec3(-4.0f, floorY - 0.1f, -2.0f), glm::vec3(12.0f, floorY, 8.0f));
+    // a bench seat on the deck beside the path, higher than a step, that only a side probe reaches
+    const float benchDeck = deckHeight(3.75f);
+    addBox(bench, glm::vec3(3.6f, benchDeck + 0.46f, 2.2f), glm::vec3(4.4f, benchDeck + 0.49f, 3.0f - playerRadius * 0.7f + 0.005f));
+
+    gps::ColliderSettings settings;
+    settings.minTop = groundMinY - playerRadius;
+    settings.maxBottom = ceilingMaxY;
+    std::vector<gps::AABB> boxes;
+    gps::ModelColliders::fromTriangles(planks, settings, boxes);
+    size_t plankBoxes = boxes.size();
+    gps::ModelColliders::fromTriangles(rails, settings, boxes);
+    size_t railBoxes = boxes.size() - plankBoxes;
+    gps::ModelColliders::fromTriangles(bench, settings, boxes);
+
+    gps::ColliderGrid grid;
+    grid.build(boxes);
+    std::vector<gps::Triangle> all = planks;
+    all.insert(all.end(), rails.begin(), rails.end());
+    all.insert(all.end(), bench.begin(), bench.end());
+    all.insert(all.end(), ground.begin(), ground.end());
+    gps::TriangleBVH bvh;
+    bvh.build(all);
+
+    // walk along the deck to its middle, 5 cm per frame
+    glm::vec3 p(-2.0f, groundMinY, 3.0f);
+    for (int i = 0; i < 120; i++)
+        p = moveCamera(grid, bvh, p, p + glm::vec3(0.05f, 0.0f, 0.0f));
+    bool onDeck = p.x > 3.9f && std::fabs(p.y - (deckHeight(p.x - 0.25f) + eyeHeight)) < 0.15f;
+    std::cout << "Bridge walk: " << plankBoxes << " plank colliders, " << railBoxes << " railing colliders, reached x = "
+        << p.x << " at eye height " << p.y - floorY << " above the floor (deck " << deckHeight(p.x) - floorY << ")" << std::endl;
+
+    // then sideways into the railing
+    for (int i = 0; i < 60; i++)
+        p = moveCamera(grid, bvh, p, p + glm::vec3(0.0f, 0.0f, 0.05f));
+    bool stopped = p.z < 4.05f - playerRadius + 0.01f;
+    std::cout << "  into the railing: stopped at z = " << p.z << std::endl;
+
+    // next to the bench, a little below the deck (as after a frame on the rising arch):
+    // the deck under the centre must still lift the camera
+    p = glm::vec3(3.8f, benchDeck + eyeHeight - 0.1f, 3.0f);
+    p = moveCamera(grid, bvh, p, p + glm::vec3(0.0f, 0.0f, 0.001f));
+    bool lifted = std::fabs(p.y - (benchDeck + eyeHeight)) < 0.01f;
+    std::cout << "  beside the bench: eye height " << p.y - benchDeck << " above the deck" << std::endl;
+
+    if (plankBoxes != 0 || !onDeck || !stopped || !lifted) {
+        std::cout << "ERROR: bridge walk failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "  ok" << std::endl;
+    return EXIT_SUCCESS;
 }
 
 void printCameraPosition()
@@ -435,10 +666,74 @@ static void applyRenderMode()
     }
 }
 
+// (re)creates the weighted blended OIT targets at the given size
+void resizePetalOIT(int width, int height)
+{
+    if (oitFBO == 0 || (width == oitWidth && height == oitHeight))
+        return;
+
+    oitWidth = width;
+    oitHeight = height;
+
+    glBindTexture(GL_TEXTURE_2D, oitAccumTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+
+    glBindTexture(GL_TEXTURE_2D, oitRevealTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, width, height, 0, GL_RED, GL_HALF_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // same format as the default framebuffer so its depth can be blitted in
+    glBindRenderbuffer(GL_RENDERBUFFER, oitDepthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    long long pixels = (long long)width * height;
+    gps::ResourceTracker::add(gps::ResourceTracker::Kind::Texture, oitAccumTex, "renderer", "petal OIT targets", 8 * pixels);
+    gps::ResourceTracker::add(gps::ResourceTracker::Kind::Texture, oitRevealTex, "renderer", "petal OIT targets", 2 * pixels);
+    gps::ResourceTracker::add(gps::ResourceTracker::Kind::Renderbuffer, oitDepthRBO, "renderer", "petal OIT targets", 4 * pixels);
+}
+
+void initPetalOIT()
+{
+    glGenFramebuffers(1, &oitFBO);
+    glGenTextures(1, &oitAccumTex);
+    glGenTextures(1, &oitRevealTex);
+    glGenRenderbuffers(1, &oitDepthRBO);
+    glGenVertexArrays(1, &oitVAO);
+
+    GLuint targets[] = { oitAccumTex, oitRevealTex };
+    for (GLuint tex : targets) {
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    resizePetalOIT(myWindow.getWindowDimensions().width, myWindow.getWindowDimensions().height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, oitFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, oitAccumTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, oitRevealTex, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, oitDepthRBO);
+
+    GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Petal OIT framebuffer incomplete, OIT disabled" << std::endl;
+        glDeleteFramebuffers(1, &oitFBO);
+        oitFBO = 0;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, myWindow.getFramebuffer());
+
+    glGenQueries(PETAL_QUERY_COUNT, petalQueries);
+}
+
 void windowResizeCallback(GLFWwindow* window, int width, int height)
 {
     if (height == 0) height = 1;
-    glViewport(0, 0, width, height);
 
     projection = glm::perspective(glm::radians(45.0f),
         (float)width / (float)height,
@@ -450,6 +745,23 @@ void windowResizeCallback(GLFWwindow* window, int width, int height)
     fprintf(stdout, "Window resized! New width: %d , and height: %d\n", width, height);
 }
 
+// in pixels, which differ from the window size on HiDPI displays
+void framebufferResizeCallback(GLFWwindow* window, int width, int height)
+{
+    if (width == 0 || height == 0) return; // minimized
+    myWindow.setWindowDimensions({ width, height });
+    glViewport(0, 0, width, height);
+    resizePetalOIT(width, height);
+}
+
+// the overlay shows GPU pass times, so the profiler starts with it
+static void showHud(bool visible)
+{
+    if (visible && !gpuProfiler.enabled())
+        gpuProfiler.init();
+    hud.setVisible(visible);
+}
+
 void keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mode)
 {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
@@ -471,20 +783,15 @@ void keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int
         if (key == GLFW_KEY_F1) renderMode = RenderMode::Solid;
         if (key == GLFW_KEY_F2) renderMode = RenderMode::Wireframe;
         if (key == GLFW_KEY_F3) renderMode = RenderMode::Points;
+        if (key == GLFW_KEY_F4) showHud(!hud.visible());
         if (key == GLFW_KEY_ENTER && action == GLFW_PRESS)
         {
             enterPressed = true;
         }
 
+        // the simulation thread owns the camera, it switches on its next step
         if (key == GLFW_KEY_P && action == GLFW_PRESS)
-        {
-            presentationMode = !presentationMode;
-            presentationIndex = 0;
-            presentationT = 0.0f;
-
-            if (presentationMode)
-                myCamera.setPosition(presentationPoints[0]);
-        }
+            presentationToggle = true;
         
         if (key == GLFW_KEY_O && action == GLFW_PRESS)
         {
@@ -500,6 +807,58 @@ void keyboardCallback(GLFWwindow* window, int key, int scancode, int action, int
                 << std::endl;
         }
 
+        if (key == GLFW_KEY_M && action == GLFW_PRESS)
+        {
+            // procedural -> CPU -> GPU
+            if (petalMode == PetalMode::Procedural) petalMode = PetalMode::Cpu;
+            else if (petalMode == PetalMode::Cpu) petalMode = PetalMode::Gpu;
+            else petalMode = PetalMode::Procedural;
+
+            std::cout << "Petals: "
+                << (petalMode == PetalMode::Cpu ? "CPU simulation" :
+                    petalMode == PetalMode::Gpu ? "GPU simulation" : "procedural")
+                << std::endl;
+        }
+
+        if (key == GLFW_KEY_N && action == GLFW_PRESS)
+        {
+            // unsorted -> sorted -> weighted OIT
+            if (petalBlend == PetalBlend::Unsorted) petalBlend = PetalBlend::Sorted;
+            else if (petalBlend == PetalBlend::Sorted) petalBlend = PetalBlend::WeightedOIT;
+            else petalBlend = PetalBlend::Unsorted;
+
+            std::cout << "Petal blending: "
+                << (petalBlend == PetalBlend::Sorted ? "depth sorted (CPU petals only)" :
+                    petalBlend == PetalBlend::WeightedOIT ? "weighted blended OIT" : "unsorted")
+                << std::endl;
+        }
+
+        if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+        {
+            gps::GLStats::setConsoleReport(!gps::GLStats::consoleReportEnabled());
+            std::cout << "GL stats: " << (gps::GLStats::consoleReportEnabled() ? "ON" : "OFF") << std::endl;
+        }
+
+        if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+            std::cout << gps::ResourceTracker::report();
+
+        if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+        {
+            char stamp[32];
+            std::time_t now = std::time(nullptr);
+            std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+
+            if (!(mode & GLFW_MOD_SHIFT)) {
+                std::string fileName = std::string("screenshot_") + stamp + ".png";
+                frameCapture.screenshot(fileName);
+                std::cout << "Screenshot: " << fileName << std::endl;
+            }
+            else if (frameCapture.recording())
+                frameCapture.stopSequence();
+            else
+                frameCapture.startSequence(std::string("capture_") + stamp, captureFormat);
+        }
+
         if (key == GLFW_KEY_F11 && action == GLFW_PRESS)
         {
             toggleFullscreen(window);
@@ -525,12 +884,13 @@ void mouseCallback(GLFWwindow* window, double xpos, double ypos)
     xoffset *= mouseSensitivity;
     yoffset *= mouseSensitivity;
 
-    myCamera.rotate((float)yoffset, (float)xoffset);
+    std::lock_guard<std::mutex> lock(lookMutex);
+    pendingLook += glm::vec2((float)yoffset, (float)xoffset);
 }
 
 static void updateDeltaTime()
 {
-    float currentFrame = (float)glfwGetTime();
+    float currentFrame = (float)frameClock();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
 }
@@ -553,9 +913,10 @@ static void moveSelectedObject(glm::vec3 deltaPos, glm::vec3 deltaRotDeg, float
     *sca = glm::max(0.05f, (*sca + deltaScale));
 }
 
-void processMovement()
+void processMovement(float dt)
 {
-    float v = cameraSpeed * deltaTime;
+    float v = cameraSpeed * dt;
+    glm::vec3 previousCameraPos = myCamera.getPosition();
 
     if (!presentationMode) {
         if (pressedKeys[GLFW_KEY_W]) myCamera.move(gps::MOVE_FORWARD, v);
@@ -564,8 +925,8 @@ void processMovement()
         if (pressedKeys[GLFW_KEY_D]) myCamera.move(gps::MOVE_RIGHT, v);
     }
 
-    float r = 60.0f * deltaTime;
-    float s = 0.6f * deltaTime;
+    float r = 60.0f * dt;
+    float s = 0.6f * dt;
 
     if (pressedKeys[GLFW_KEY_Q]) moveSelectedObject(glm::vec3(0), glm::vec3(0, -r, 0), 0);
     if (pressedKeys[GLFW_KEY_E]) moveSelectedObject(glm::vec3(0), glm::vec3(0, r, 0), 0);
@@ -583,18 +944,101 @@ void processMovement()
     }
 
     if (!presentationMode) {
-        solveCameraCollisions();
+        solveCameraCollisions(previousCameraPos);
+    }
+}
+
+// accumulation pass: petals go to the OIT targets, depth-tested against the opaque scene
+static void beginPetalOIT()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, myWindow.getFramebuffer());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, oitFBO);
+    glBlitFramebuffer(0, 0, oitWidth, oitHeight, 0, 0, oitWidth, oitHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, oitFBO);
+
+    const GLfloat clearAccum[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat clearReveal[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glClearBufferfv(GL_COLOR, 0, clearAccum);
+    glClearBufferfv(GL_COLOR, 1, clearReveal);
+
+    glEnable(GL_BLEND);
+    glBlendFunci(0, GL_ONE, GL_ONE);
+    glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    glDepthMask(GL_FALSE);
+}
+
+// resolve pass: average petal colour blended over the scene by the total coverage
+static void endPetalOIT()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, myWindow.getFramebuffer());
+
+    oitCompositeShader.useShaderProgram();
+    GLint loc = glGetUniformLocation(oitCompositeShader.shaderProgram, "accumTexture");
+    if (loc != -1) glUniform1i(loc, 0);
+    loc = glGetUniformLocation(oitCompositeShader.shaderProgram, "revealTexture");
+    if (loc != -1) glUniform1i(loc, 1);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, oitAccumTex);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, oitRevealTex);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+
+    glBindVertexArray(oitVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// collects the petal pass timers the GPU has finished (a frame or more late), so it never stalls
+static void logPetalTiming()
+{
+    for (int q = 0; q < PETAL_QUERY_COUNT; q++) {
+        if (!petalQueryPending[q])
+            continue;
+        GLuint available = 0;
+        glGetQueryObjectuiv(petalQueries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(petalQueries[q], GL_QUERY_RESULT, &ns);
+        petalQueryPending[q] = false;
+        petalGpuMsSum += ns / 1.0e6;
+        petalGpuSamples++;
+    }
+
+    if (petalGpuSamples == petalTimingFrames) {
+        const char* blend = petalBlend == PetalBlend::Sorted ? "sorted" :
+            petalBlend == PetalBlend::WeightedOIT ? "weighted OIT" : "unsorted";
+        int count = petalMode == PetalMode::Cpu ? sakuraParticles.count() :
+            petalMode == PetalMode::Gpu ? gpuSakuraParticles.count() : PETAL_COUNT;
+
+        std::cout << "Petal pass (" << count << " petals, " << blend << "): "
+            << petalGpuMsSum / petalGpuSamples << " ms GPU" << std::endl;
+
+        petalGpuMsSum = 0.0;
+        petalGpuSamples = 0;
     }
 }
 
 void initOpenGLWindow()
 {
-    myWindow.Create(1024, 768, "OpenGL Project Core");
+    myWindow.Create(1024, 768, "OpenGL Project Core", headless);
 }
 
 void setWindowCallbacks()
 {
     glfwSetWindowSizeCallback(myWindow.getWindow(), windowResizeCallback);
+    glfwSetFramebufferSizeCallback(myWindow.getWindow(), framebufferResizeCallback);
     glfwSetKeyCallback(myWindow.getWindow(), keyboardCallback);
     glfwSetCursorPosCallback(myWindow.getWindow(), mouseCallback);
 
@@ -615,31 +1059,99 @@ void initOpenGLState()
     glFrontFace(GL_CCW);
 }
 
-void initModels()
+// poll phase of the shader submit: resolves programs the driver already finished,
+// so their first use does not wait; the rest are resolved by useShaderProgram
+static void finishReadyShaders()
 {
-    garden.LoadModel("models/japan_garden/garden.obj");
-    pug.LoadModel("models/pug_mabel/pug.obj");
+    gps::Shader* shaders[] = { &myBasicShader, &sakuraShader, &petalShader, &petalUpdateShader, &petalOitShader,
+        &sakuraOitShader, &oitCompositeShader, &skyboxShader, &depthShader };
+    for (gps::Shader* shader : shaders)
+        if (shader->isReady())
+            shader->finishShader();
+}
 
-    gardenScale = 0.03f;
-    pugScale = 0.8f;
+// the scene file has already been loaded into `scene`
+void initModels()
+{
+    PROFILE_ZONE("initModels");
+    sceneModels.clear();
+    sceneTransforms.clear();
+    props.clear();
+    propTransforms.clear();
+    transforms.clear();
+    gardenTransform = pugTransform = gps::TransformStore::NONE;
+
+    for (const gps::SceneModel& m : scene.models) {
+        // the scene guarantees parents are listed first
+        gps::TransformId parent = gps::TransformStore::NONE;
+        for (size_t p = 0; p < sceneModels.size(); p++)
+            if (!m.parent.empty() && scene.models[p].name == m.parent) parent = sceneTransforms[p];
+
+        gps::TransformId id = transforms.create(m.position,
+            gps::TransformStore::fromEulerDegrees(m.rotation), m.scale, parent);
+
+        gps::Model3D* model;
+        if (m.name == "garden") {
+            model = &garden;
+            gardenTransform = id;
+            gardenPos = m.position;
+            gardenRot = m.rotation;
+            gardenScale = m.scale;
+        }
+        else if (m.name == "pug") {
+            model = &pug;
+            pugTransform = id;
+            pugPos = m.position;
+            pugRot = m.rotation;
+            pugScale = m.scale;
+        }
+        else {
+            props.emplace_back(new gps::Model3D());
+            model = props.back().get();
+            propTransforms.push_back(id);
+        }
 
-    gardenPos = glm::vec3(0.0f);
-    gardenRot = glm::vec3(0.0f);
+        model->LoadModel(m.path);
+        sceneModels.push_back(model);
+        sceneTransforms.push_back(id);
 
-    pugPos = glm::vec3(3.4273f, 0.800309f, 6.92084f);
-    pugRot = glm::vec3(0.0f, 230.0f, 0.0f);
+        // shaders compile on the driver's threads while the models load
+        finishReadyShaders();
+    }
 
-    colliders.clear();
+    // the keyboard and the pug animation always have something to move
+    if (gardenTransform == gps::TransformStore::NONE)
+        gardenTransform = transforms.create(gardenPos, glm::quat(), gardenScale);
+    if (pugTransform == gps::TransformStore::NONE)
+        pugTransform = transforms.create(pugPos, glm::quat(), pugScale);
 
-    colliders.push_back(AABB{
-        glm::vec3(15.35f, 0.75f, 7.0f),  
-        glm::vec3(16.10f, 3.8f, 16.2f)    
-        });
+    transforms.update();
+    colliderTransforms = transforms;
+    colliders = scene.colliders;
+}
 
-    colliders.push_back(AABB{
-        glm::vec3(-3.3f, 0.6f, -2.8f),
-        glm::vec3(7.8f,  1.9f,  7.2f)
-        });
+// bounds, camera, lights, emitters and the presentation path
+void initSceneSettings()
+{
+    gardenMinX = scene.boundsX.x;
+    gardenMaxX = scene.boundsX.y;
+    gardenMinZ = scene.boundsZ.x;
+    gardenMaxZ = scene.boundsZ.y;
+    groundMinY = scene.floorY;
+    ceilingMaxY = scene.ceilingY;
+
+    myCamera = gps::Camera(scene.cameraPosition, scene.cameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+    presentationPoints = scene.cameraPath;
+    sakuraTrees = scene.emitters;
+
+    lampPos = glm::vec3(0.0f);
+    lampColor = glm::vec3(0.0f);
+    for (const gps::SceneLight& l : scene.lamps) {
+        lampPos += l.position;
+        lampColor += l.color;
+    }
+    if (!scene.lamps.empty())
+        lampPos /= (float)scene.lamps.size();
 }
 
 void initShadowMap()
@@ -652,6 +1164,8 @@ void initShadowMap()
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
         SHADOW_WIDTH, SHADOW_HEIGHT, 0,
         GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    gps::ResourceTracker::add(gps::ResourceTracker::Kind::Texture, shadowMap, "renderer", "shadow map",
+        4LL * SHADOW_WIDTH * SHADOW_HEIGHT);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -668,17 +1182,27 @@ void initShadowMap()
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, myWindow.getFramebuffer());
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+// only submits the programs; they finish compiling while models and textures load
+// and are resolved on first use (initSkybox / initUniforms / first frame)
 void initShaders()
 {
-    myBasicShader.loadShader("shaders/basic.vert", "shaders/basic.frag");
-    sakuraShader.loadShader("shaders/sakura.vert", "shaders/sakura.frag");
-    skyboxShader.loadShader("shaders/skybox.vert", "shaders/skybox.frag");
+    PROFILE_ZONE("initShaders");
+    gps::Shader::enableParallelCompile();
+
+    myBasicShader.submitShader("shaders/basic.vert", "shaders/basic.frag");
+    sakuraShader.submitShader("shaders/sakura.vert", "shaders/sakura.frag");
+    petalShader.submitShader("shaders/petal.vert", "shaders/sakura.frag");
+    petalUpdateShader.submitFeedbackShader("shaders/petal_update.vert", { "tfPosLife", "tfVelocity" });
+    petalOitShader.submitShader("shaders/petal.vert", "shaders/petal_oit.frag");
+    sakuraOitShader.submitShader("shaders/sakura.vert", "shaders/petal_oit.frag");
+    oitCompositeShader.submitShader("shaders/oit_composite.vert", "shaders/oit_composite.frag");
+    skyboxShader.submitShader("shaders/skybox.vert", "shaders/skybox.frag");
     // shadow depth shader
-    depthShader.loadShader("shaders/depth.vert", "shaders/depth.frag");
+    depthShader.submitShader("shaders/depth.vert", "shaders/depth.frag");
 }
 
 void initUniforms()
@@ -702,12 +1226,12 @@ void initUniforms()
     glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
     // directional light
-    lightDir = glm::normalize(glm::vec3(-0.5f, 0.6f, 0.6f));
+    lightDir = scene.sunDirection;
 
     lightDirLoc = glGetUniformLocation(myBasicShader.shaderProgram, "lightDir");
     if (lightDirLoc != -1) glUniform3fv(lightDirLoc, 1, glm::value_ptr(lightDir));
 
-    lightColor = glm::vec3(1.0f, 0.75f, 0.55f);
+    lightColor = scene.sunColor;
     lightColorLoc = glGetUniformLocation(myBasicShader.shaderProgram, "lightColor");
     if (lightColorLoc != -1) glUniform3fv(lightColorLoc, 1, glm::value_ptr(lightColor));
 
@@ -763,32 +1287,61 @@ void initUniforms()
 
 }
 
-static glm::mat4 composeModelMatrix(glm::vec3 pos, glm::vec3 rotDeg, float scale)
+void initColliders()
 {
-    glm::mat4 m(1.0f);
-    m = glm::translate(m, pos);
-    m = glm::rotate(m, glm::radians(rotDeg.y), glm::vec3(0, 1, 0));
-    m = glm::rotate(m, glm::radians(rotDeg.x), glm::vec3(1, 0, 0));
-    m = glm::rotate(m, glm::radians(rotDeg.z), glm::vec3(0, 0, 1));
-    m = glm::scale(m, glm::vec3(scale));
-    return m;
+    PROFILE_ZONE("initColliders");
+    std::vector<gps::AABB> cameraColliders = colliders;
+
+    std::vector<gps::Triangle> groundTriangles;
+
+    gps::ColliderSettings settings;
+    settings.minTop = groundMinY - playerRadius;
+    settings.maxBottom = ceilingMaxY;
+
+    // every model flagged "collide" in the scene blocks the camera and is walked on
+    for (size_t i = 0; i < scene.models.size(); i++) {
+        const gps::SceneModel& m = scene.models[i];
+        if (!m.collide) continue;
+
+        const glm::mat4& modelMatrix = colliderTransforms.world(sceneTransforms[i]);
+        if (autoColliders)
+            gps::ModelColliders::build(*sceneModels[i], modelMatrix, settings, cameraColliders);
+        gps::ModelColliders::triangles(*sceneModels[i], modelMatrix, groundTriangles);
+    }
+
+    colliderGrid.build(cameraColliders);
+    groundBVH.build(groundTriangles);
 }
-static void renderModelWithShader(gps::Model3D& m, gps::Shader& shader, const glm::mat4& modelMatrix, bool uploadNormalMatrix)
+
+// the garden or the pug was moved with Q/E/Z/X: colliders and walkable ground follow
+static void rebuildColliders()
 {
+    PROFILE_ZONE("rebuildColliders");
+    colliderTransforms.setLocal(gardenTransform, gardenPos, gps::TransformStore::fromEulerDegrees(gardenRot), gardenScale);
+    colliderTransforms.setLocal(pugTransform, pugPos, gps::TransformStore::fromEulerDegrees(pugRot), pugScale);
+    colliderTransforms.update();
+    initColliders();
+}
+
+static void renderModelWithShader(gps::Model3D& m, gps::Shader& shader, gps::TransformId transform,
+    const glm::mat4& viewProjection, bool uploadNormalMatrix)
+{
+    const glm::mat4& modelMatrix = transforms.world(transform);
     shader.useShaderProgram();
 
     GLint locModel = glGetUniformLocation(shader.shaderProgram, "model");
     if (locModel != -1) glUniformMatrix4fv(locModel, 1, GL_FALSE, glm::value_ptr(modelMatrix));
 
     if (uploadNormalMatrix && shader.shaderProgram == myBasicShader.shaderProgram) {
-        glm::mat3 normalMatrix = glm::mat3(glm::inverseTranspose(view * modelMatrix));
+        // the view is rigid, so only the cached world normal matrix needs an inverse
+        glm::mat3 normalMatrix = glm::mat3(view) * transforms.normalMatrix(transform);
         glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, glm::value_ptr(normalMatrix));
     }
 
-    m.Draw(shader);
+    m.Draw(shader, viewProjection * modelMatrix);
 }
 
-static void updatePresentationCamera()
+static void updatePresentationCamera(float dt)
 {
     if (presentationPoints.size() < 2)
         return;
@@ -796,7 +1349,7 @@ static void updatePresentationCamera()
     glm::vec3 p0 = presentationPoints[presentationIndex];
     glm::vec3 p1 = presentationPoints[(presentationIndex + 1) % presentationPoints.size()];
 
-    presentationT += deltaTime * presentationSpeed;
+    presentationT += dt * presentationSpeed;
 
     if (presentationT >= 1.0f) {
         presentationT = 0.0f;
@@ -809,58 +1362,251 @@ static void updatePresentationCamera()
     glm::vec3 lookTarget = glm::mix(p0, p1, glm::min(presentationT + 0.05f, 1.0f));
 
     myCamera.setPosition(camPos);
-    view = glm::lookAt(camPos, lookTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+    simCurrent.lookTarget = lookTarget;
+}
 
-    myBasicShader.useShaderProgram();
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+static void togglePresentation()
+{
+    presentationMode = !presentationMode;
+    presentationIndex = 0;
+    presentationT = 0.0f;
+
+    if (presentationMode) {
+        myCamera.setPosition(presentationPoints[0]);
+        simCurrent.lookTarget = presentationPoints[1 % presentationPoints.size()];
+    }
+
+    // jump instead of interpolating from the old position
+    simCurrent.cameraPos = myCamera.getPosition();
+    simPrevious = simCurrent;
+}
+
+// one fixed simulation step
+static void simulateStep(float dt)
+{
+    PROFILE_ZONE("simulateStep");
+    if (presentationToggle.exchange(false))
+        togglePresentation();
+
+    glm::vec2 look;
+    {
+        std::lock_guard<std::mutex> lock(lookMutex);
+        look = pendingLook;
+        pendingLook = glm::vec2(0.0f);
+    }
+    if (look.x != 0.0f || look.y != 0.0f)
+        myCamera.rotate(look.x, look.y);
+
+    simPrevious = simCurrent;
+
+    processMovement(dt);
+
+    // regenerating is not per-step work, so wait until the keys are released
+    bool editing = pressedKeys[GLFW_KEY_Q] || pressedKeys[GLFW_KEY_E] || pressedKeys[GLFW_KEY_Z] || pressedKeys[GLFW_KEY_X];
+    if (editing) collidersStale = true;
+    else if (collidersStale) {
+        collidersStale = false;
+        rebuildColliders();
+    }
+
+    if (presentationMode) updatePresentationCamera(dt);
+    sakuraTime += dt * 0.6f;
+
+    simCurrent.cameraPos = myCamera.getPosition();
+    simCurrent.time += dt;
+    simCurrent.sakuraTime = sakuraTime;
 }
 
+static void publishFrameState(double stepTime)
+{
+    FrameState& f = frameStates.back();
+    f.previous = simPrevious;
+    f.current = simCurrent;
+    f.stepTime = stepTime;
+
+    f.cameraFront = myCamera.getFrontDirection();
+    f.cameraUp = myCamera.getUpDirection();
+    f.presentation = presentationMode;
+
+    f.gardenPos = gardenPos; f.gardenRot = gardenRot; f.gardenScale = gardenScale;
+    f.pugPos = pugPos; f.pugRot = pugRot; f.pugScale = pugScale;
+    f.lightDir = lightDir;
+
+    frameStates.publish();
+}
+
+// paces fixed steps against the wall clock and publishes after each batch
+static void simulationLoop()
+{
+    gps::Profiler::setThreadName("simulation");
+    double next = glfwGetTime();
+    double stepTime = next;
+
+    while (simRunning) {
+        double now = glfwGetTime();
+        if (now < next) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(next - now));
+            continue;
+        }
+
+        int steps = 0;
+        while (now >= next && steps < MAX_SIM_STEPS) {
+            simulateStep(simStep);
+            stepTime = next;
+            next += simStep;
+            steps++;
+        }
+
+        // too far behind (hitch, debugger): drop the backlog instead of spiralling
+        if (now >= next) {
+            stepTime = now;
+            next = now + simStep;
+        }
 
+        publishFrameState(stepTime);
+    }
+}
 
-void renderSakuraPetals()
+static void startSimulation()
 {
-    if (sakuraVAO == 0 || sakuraShader.shaderProgram == 0)
+    simCurrent.cameraPos = myCamera.getPosition();
+    simCurrent.sakuraTime = sakuraTime;
+    simPrevious = simCurrent;
+    lastFrame = (float)frameClock();
+    publishFrameState(frameClock());
+
+    if (singleThreaded)
         return;
 
-    sakuraShader.useShaderProgram();
+    simRunning = true;
+    simThread = std::thread(simulationLoop);
+}
 
-    sakuraTime += deltaTime * 0.6f;
+static void stopSimulation()
+{
+    simRunning = false;
+    if (simThread.joinable())
+        simThread.join();
+}
 
+// --single-thread: runs as many fixed steps as the elapsed frame time allows;
+// a long hitch is capped so the simulation slows down instead of spiralling
+static void advanceSimulation()
+{
+    PROFILE_ZONE("advanceSimulation");
+    simAccumulator += glm::min(deltaTime, MAX_FRAME_TIME);
+
+    int steps = 0;
+    while (simAccumulator >= simStep && steps < MAX_SIM_STEPS) {
+        simulateStep(simStep);
+        simAccumulator -= simStep;
+        steps++;
+    }
+    if (steps == MAX_SIM_STEPS)
+        simAccumulator = glm::min(simAccumulator, simStep);
+
+    publishFrameState(frameClock() - simAccumulator);
+}
+
+
+
+void renderSakuraPetals(float petalTime, float petalStep)
+{
     GLint loc;
 
-    loc = glGetUniformLocation(sakuraShader.shaderProgram, "uTime");
-    if (loc != -1) glUniform1f(loc, sakuraTime);
+    bool simulated = petalMode != PetalMode::Procedural;
+    bool oit = petalBlend == PetalBlend::WeightedOIT && oitFBO != 0;
+
+    gps::Shader& shader = simulated
+        ? (oit ? petalOitShader : petalShader)
+        : (oit ? sakuraOitShader : sakuraShader);
+
+    if (shader.shaderProgram == 0 || (!simulated && sakuraVAO == 0))
+        return;
+
+    if (petalMode == PetalMode::Cpu) {
+        // petals for this frame were simulated while the previous one rendered
+        sakuraParticles.finishUpdate();
+        if (petalBlend == PetalBlend::Sorted)
+            sakuraParticles.sortByDepth(view, &jobSystem);
+        sakuraParticles.upload();
+
+        // simulate the next frame on the workers while this one draws
+        sakuraParticles.beginUpdate(jobSystem, petalTime, petalStep);
+    }
+    else if (petalMode == PetalMode::Gpu) {
+        gpuSakuraParticles.update(petalTime, petalStep);
+    }
+
+    // skip timing this frame while the GPU still owes every query slot
+    int querySlot = petalQueryFrame % PETAL_QUERY_COUNT;
+    bool timed = petalTimingLog && !petalQueryPending[querySlot];
+    if (timed)
+        glBeginQuery(GL_TIME_ELAPSED, petalQueries[querySlot]);
 
-    glm::mat4 view = myCamera.getViewMatrix();
+    shader.useShaderProgram();
 
-    loc = glGetUniformLocation(sakuraShader.shaderProgram, "view");
+    loc = glGetUniformLocation(shader.shaderProgram, "view");
     if (loc != -1) glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(view));
 
-    loc = glGetUniformLocation(sakuraShader.shaderProgram, "projection");
+    loc = glGetUniformLocation(shader.shaderProgram, "projection");
     if (loc != -1) glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(projection));
-    GLint treeALoc = glGetUniformLocation(sakuraShader.shaderProgram, "treePosA");
-    if (treeALoc != -1)
-        glUniform3fv(treeALoc, 1, glm::value_ptr(sakuraTreePosA));
 
-    GLint treeBLoc = glGetUniformLocation(sakuraShader.shaderProgram, "treePosB");
-    if (treeBLoc != -1)
-        glUniform3fv(treeBLoc, 1, glm::value_ptr(sakuraTreePosB));
-
-    GLint treeCLoc = glGetUniformLocation(sakuraShader.shaderProgram, "treePosC");
-    if (treeCLoc != -1)
-        glUniform3fv(treeCLoc, 1, glm::value_ptr(sakuraTreePosC));
+    if (simulated)
+    {
+        loc = glGetUniformLocation(shader.shaderProgram, "regionBase");
+        if (loc != -1) glUniform1i(loc, petalMode == PetalMode::Cpu ? sakuraParticles.drawBase() : 0);
+    }
+    else
+    {
+        loc = glGetUniformLocation(shader.shaderProgram, "uTime");
+        if (loc != -1) glUniform1f(loc, petalTime);
+
+        // fewer than three trees: repeat the last one
+        const char* treeUniforms[3] = { "treePosA", "treePosB", "treePosC" };
+        for (int t = 0; t < 3 && !sakuraTrees.empty(); t++) {
+            GLint treeLoc = glGetUniformLocation(shader.shaderProgram, treeUniforms[t]);
+            if (treeLoc != -1)
+                glUniform3fv(treeLoc, 1, glm::value_ptr(sakuraTrees[std::min(t, (int)sakuraTrees.size() - 1)]));
+        }
+    }
 
+    if (oit) {
+        beginPetalOIT();
+    }
+    else {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+    }
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDepthMask(GL_FALSE);
+    if (petalMode == PetalMode::Cpu) {
+        sakuraParticles.draw();
+    }
+    else if (petalMode == PetalMode::Gpu) {
+        gpuSakuraParticles.draw();
+    }
+    else {
+        glBindVertexArray(sakuraVAO);
+        glDrawArrays(GL_POINTS, 0, PETAL_COUNT);
+        glBindVertexArray(0);
+    }
 
-    glBindVertexArray(sakuraVAO);
-    glDrawArrays(GL_POINTS, 0, PETAL_COUNT);
-    glBindVertexArray(0);
+    if (oit) {
+        endPetalOIT();
+    }
+    else {
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
 
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
+    if (timed) {
+        glEndQuery(GL_TIME_ELAPSED);
+        petalQueryPending[querySlot] = true;
+        petalQueryFrame++;
+    }
+    if (petalTimingLog)
+        logPetalTiming();
 }
 
 void renderSkybox()
@@ -870,7 +1616,7 @@ void renderSkybox()
 
     skyboxShader.useShaderProgram();
 
-    glm::mat4 viewNoTrans = glm::mat4(glm::mat3(myCamera.getViewMatrix()));
+    glm::mat4 viewNoTrans = glm::mat4(glm::mat3(view));
     GLint viewLocSB = glGetUniformLocation(skyboxShader.shaderProgram, "view");
     if (viewLocSB != -1) glUniformMatrix4fv(viewLocSB, 1, GL_FALSE, glm::value_ptr(viewNoTrans));
 
@@ -888,20 +1634,39 @@ void renderSkybox()
     glDepthFunc(GL_LESS);
 }
 
-void renderScene()
+void renderScene(const FrameState& frame)
 {
-
-    float time = (float)glfwGetTime();
-    glm::vec3 pugAnimPos = pugPos;
-    glm::vec3 pugAnimRot = pugRot;
+    PROFILE_ZONE("renderScene");
+    // render state interpolated between the last two simulation steps
+    float alpha = glm::clamp((float)((frameClock() - frame.stepTime) / simStep), 0.0f, 1.0f);
+    float time = glm::mix(frame.previous.time, frame.current.time, alpha);
+    float petalTime = glm::mix(frame.previous.sakuraTime, frame.current.sakuraTime, alpha);
+    glm::vec3 cameraPos = glm::mix(frame.previous.cameraPos, frame.current.cameraPos, alpha);
+
+    // petals advance by the simulated time since the last frame, clamped so a long
+    // hitch does not blow up the integration
+    static float lastRenderTime = time;
+    float petalStep = glm::clamp(time - lastRenderTime, 0.0f, 0.05f);
+    lastRenderTime = time;
+
+    glm::vec3 pugAnimPos = frame.pugPos;
+    glm::vec3 pugAnimRot = frame.pugRot;
     pugAnimPos.y += 0.08f * std::sin(time * 2.0f);
     pugAnimRot.y += 6.0f * std::sin(time * 1.2f);
 
-    glm::mat4 gardenModel = composeModelMatrix(gardenPos, gardenRot, gardenScale);
-    glm::mat4 pugModel = composeModelMatrix(pugAnimPos, pugAnimRot, pugScale);
+    transforms.setLocal(gardenTransform, frame.gardenPos,
+        gps::TransformStore::fromEulerDegrees(frame.gardenRot), frame.gardenScale);
+    transforms.setLocal(pugTransform, pugAnimPos,
+        gps::TransformStore::fromEulerDegrees(pugAnimRot), frame.pugScale);
+    transforms.update();
 
-    if (presentationMode) updatePresentationCamera();
-    else view = myCamera.getViewMatrix();
+    if (frame.presentation) {
+        glm::vec3 lookTarget = glm::mix(frame.previous.lookTarget, frame.current.lookTarget, alpha);
+        view = glm::lookAt(cameraPos, lookTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    else {
+        view = glm::lookAt(cameraPos, cameraPos + frame.cameraFront, frame.cameraUp);
+    }
 
     float near_plane = 1.0f;
     float far_plane = 60.0f;
@@ -914,11 +1679,12 @@ void renderScene()
         0.5f * (gardenMinZ + gardenMaxZ)
     );
 
-    glm::vec3 lightPos = sceneCenter - lightDir * 25.0f;
+    glm::vec3 lightPos = sceneCenter - frame.lightDir * 25.0f;
     glm::mat4 lightView = glm::lookAt(lightPos, sceneCenter, glm::vec3(0.0f, 1.0f, 0.0f));
 
     lightSpaceMatrix = lightProjection * lightView;
 
+    gpuProfiler.beginPass("shadow");
     glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
     glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
     glClear(GL_DEPTH_BUFFER_BIT);
@@ -927,10 +1693,13 @@ void renderScene()
     GLint lsmLocDepth = glGetUniformLocation(depthShader.shaderProgram, "lightSpaceMatrix");
     if (lsmLocDepth != -1) glUniformMatrix4fv(lsmLocDepth, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
 
-    renderModelWithShader(garden, depthShader, gardenModel, false);
-    renderModelWithShader(pug, depthShader, pugModel, false);
+    renderModelWithShader(garden, depthShader, gardenTransform, lightSpaceMatrix, false);
+    renderModelWithShader(pug, depthShader, pugTransform, lightSpaceMatrix, false);
+    for (size_t i = 0; i < props.size(); i++)
+        renderModelWithShader(*props[i], depthShader, propTransforms[i], lightSpaceMatrix, false);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, myWindow.getFramebuffer());
+    gpuProfiler.endPass();
 
     // restore viewport to screen
     glViewport(0, 0, myWindow.getWindowDimensions().width, myWindow.getWindowDimensions().height);
@@ -972,11 +1741,9 @@ void renderScene()
     //  GARDEN LAMPS 
     if (lampsEnabled && lightPos2Loc != -1 && lightColor2Loc != -1)
     {
-        glm::vec3 blendedPos = 0.5f * (lampPosA + lampPosB);
-        glUniform3fv(lightPos2Loc, 1, glm::value_ptr(blendedPos));
-
-        // stronger to simulate 2 lamps
-        glUniform3f(lightColor2Loc, 3.2f, 2.4f, 1.6f);
+        // all lamps at their average position, as bright as their sum
+        glUniform3fv(lightPos2Loc, 1, glm::value_ptr(lampPos));
+        glUniform3fv(lightColor2Loc, 1, glm::value_ptr(lampColor));
     }
     else if (lightColor2Loc != -1)
     {
@@ -984,15 +1751,42 @@ void renderScene()
     }
 
     // draw scene normally
+    gpuProfiler.beginPass("skybox");
     renderSkybox();
-    renderModelWithShader(garden, myBasicShader, gardenModel, true);
-    renderModelWithShader(pug, myBasicShader, pugModel, true);
-    renderSakuraPetals();
+    gpuProfiler.endPass();
+
+    gpuProfiler.beginPass("garden");
+    renderModelWithShader(garden, myBasicShader, gardenTransform, projection * view, true);
+    gpuProfiler.endPass();
+
+    gpuProfiler.beginPass("pug");
+    renderModelWithShader(pug, myBasicShader, pugTransform, projection * view, true);
+    gpuProfiler.endPass();
+
+    if (!props.empty()) {
+        gpuProfiler.beginPass("props");
+        for (size_t i = 0; i < props.size(); i++)
+            renderModelWithShader(*props[i], myBasicShader, propTransforms[i], projection * view, true);
+        gpuProfiler.endPass();
+    }
+
+    gpuProfiler.beginPass("petals");
+    renderSakuraPetals(petalTime, petalStep);
+    gpuProfiler.endPass();
+
+    if (hud.visible()) {
+        gpuProfiler.beginPass("hud");
+        hud.draw(myWindow.getWindowDimensions().width, myWindow.getWindowDimensions().height);
+        gpuProfiler.endPass();
+        // the shadow pass of the next frame runs before the scene sets it again
+        applyRenderMode();
+    }
 
 }
 
 void initSakuraPetals()
 {
+    PROFILE_ZONE("initSakuraPetals");
     std::vector<glm::vec3> positions;
     std::vector<float> seeds;
 
@@ -1021,6 +1815,8 @@ void initSakuraPetals()
         positions.size() * sizeof(glm::vec3),
         positions.data(),
         GL_STATIC_DRAW);
+    gps::ResourceTracker::add(gps::ResourceTracker::Kind::Buffer, sakuraVBO, "petals", "procedural",
+        (long long)(positions.size() * sizeof(glm::vec3)));
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
@@ -1031,24 +1827,360 @@ void initSakuraPetals()
         seeds.size() * sizeof(float),
         seeds.data(),
         GL_STATIC_DRAW);
+    gps::ResourceTracker::add(gps::ResourceTracker::Kind::Buffer, sakuraSeedVBO, "petals", "procedural",
+        (long long)(seeds.size() * sizeof(float)));
 
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, (void*)0);
 
     glBindVertexArray(0);
+
+    // simulated petals spawn from the scene's trees and land on the colliders
+    sakuraParticles.init(cpuPetalCount);
+    for (const glm::vec3& tree : sakuraTrees)
+        sakuraParticles.addEmitter(tree);
+    sakuraParticles.setColliders(colliders);
+    sakuraParticles.setGroundHeight(petalGroundY);
+    sakuraParticles.initBuffers();
+
+    gpuSakuraParticles.init(gpuPetalCount, &petalUpdateShader);
+    for (const glm::vec3& tree : sakuraTrees)
+        gpuSakuraParticles.addEmitter(tree);
+    gpuSakuraParticles.setColliders(colliders);
+    gpuSakuraParticles.setGroundHeight(petalGroundY);
 }
 
 
-void cleanup()
+// final image of the last frame, rows top to bottom, without alpha
+static void readFramebuffer(int width, int height, std::vector<uint8_t>& rgb)
 {
-    myWindow.Delete();
+    std::vector<uint8_t> rgba((size_t)width * height * 4);
+    GLuint framebuffer = myWindow.getFramebuffer();
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+    rgb.resize((size_t)width * height * 3);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = rgba.data() + (size_t)(height - 1 - y) * width * 4;
+        uint8_t* dst = rgb.data() + (size_t)y * width * 3;
+        for (int x = 0; x < width; x++, src += 4, dst += 3) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    }
+}
+
+// --golden: one still per camera path point, looking at the next one; returns the exit code
+static int runGoldenViews()
+{
+    if (presentationPoints.empty()) {
+        std::cout << "ERROR: the scene has no camera path to render" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int width = myWindow.getWindowDimensions().width;
+    int height = myWindow.getWindowDimensions().height;
+    std::vector<uint8_t> rgb, heatmap;
+    int failures = 0;
+
+    presentationMode = true;
+    for (size_t v = 0; v < presentationPoints.size(); v++) {
+        myCamera.setPosition(presentationPoints[v]);
+        simCurrent.cameraPos = presentationPoints[v];
+        simCurrent.lookTarget = presentationPoints[(v + 1) % presentationPoints.size()];
+        simPrevious = simCurrent;
+        publishFrameState(frameClock());
+        frameStates.acquire();
+
+        // the first frame pays for first use of every resource; the rest are timed
+        double cpuMs = 0.0, frameMs = 0.0;
+        for (int f = 0; f <= GOLDEN_TIMED_FRAMES; f++) {
+            uint64_t start = gps::Profiler::now();
+            renderScene(frameStates.front());
+            uint64_t submitted = gps::Profiler::now();
+            glFinish();
+            uint64_t end = gps::Profiler::now();
+            if (f > 0) {
+                cpuMs += (submitted - start) / 1e6;
+                frameMs += (end - start) / 1e6;
+            }
+        }
+        cpuMs /= GOLDEN_TIMED_FRAMES;
+        frameMs /= GOLDEN_TIMED_FRAMES;
+        readFramebuffer(width, height, rgb);
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "view_%02d", (int)v);
+        std::string base = goldenDir + "/" + name;
+        char timing[64];
+        std::snprintf(timing, sizeof(timing), "%6.2f ms/frame (cpu %5.2f ms)", frameMs, cpuMs);
+
+        if (goldenUpdate) {
+            gps::ImageWriter::writePng(base + ".png", width, height, rgb.data());
+            std::cout << name << "  " << timing << "  reference written" << std::endl;
+            continue;
+        }
 
+        int refWidth = 0, refHeight = 0, channels = 0;
+        unsigned char* reference = stbi_load((base + ".png").c_str(), &refWidth, &refHeight, &channels, 3);
+        bool pass = false;
+        char result[128];
+        if (!reference) {
+            std::snprintf(result, sizeof(result), "FAIL (no reference %s.png)", base.c_str());
+        }
+        else if (refWidth != width || refHeight != height) {
+            std::snprintf(result, sizeof(result), "FAIL (reference is %dx%d, rendered %dx%d)",
+                refWidth, refHeight, width, height);
+        }
+        else {
+            gps::ImageDiff diff = gps::ImageCompare::compare(reference, rgb.data(), width, height, &heatmap);
+            // a few wrong pixels may be noticeable, but hardly any may be plainly wrong
+            pass = diff.noticeable <= goldenTolerance && diff.severe <= goldenTolerance * 0.1;
+            std::snprintf(result, sizeof(result), "noticeable %5.2f%%  severe %5.2f%%  max dE %5.1f  %s",
+                100.0 * diff.noticeable, 100.0 * diff.severe, diff.maxDeltaE, pass ? "PASS" : "FAIL");
+            if (!pass)
+                gps::ImageWriter::writePng(base + ".diff.png", width, height, heatmap.data());
+        }
+        if (reference)
+            stbi_image_free(reference);
+
+        if (!pass) {
+            gps::ImageWriter::writePng(base + ".actual.png", width, height, rgb.data());
+            failures++;
+        }
+        std::cout << name << "  " << timing << "  " << result << std::endl;
+    }
+
+    if (goldenUpdate)
+        return EXIT_SUCCESS;
+    std::cout << "Golden images: " << presentationPoints.size() - failures << "/" << presentationPoints.size()
+        << " views passed" << std::endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void cleanup()
+{
+    std::cout << gps::ResourceTracker::report();
+
+    stopSimulation();
+    sakuraParticles.finishUpdate();
+    jobSystem.stop();
+    benchmarkRecorder.release();
+    gpuProfiler.release();
+    hud.release();
+    frameCapture.release();
+
+    // everything owned here goes before the context does
+    gps::ResourceTracker::remove(gps::ResourceTracker::Kind::Texture, oitAccumTex);
+    gps::ResourceTracker::remove(gps::ResourceTracker::Kind::Texture, oitRevealTex);
+    gps::ResourceTracker::remove(gps::ResourceTracker::Kind::Renderbuffer, oitDepthRBO);
+    gps::ResourceTracker::remove(gps::ResourceTracker::Kind::Texture, shadowMap);
+    gps::ResourceTracker::remove(gps::ResourceTracker::Kind::Texture, cubemapTex);
+    gps::ResourceTracker::remove(gps::ResourceTracker::Kind::Buffer, skyboxVBO);
+    gps::ResourceTracker::remove(gps::ResourceTracker::Kind::Buffer, sakuraVBO);
+    gps::ResourceTracker::remove(gps::ResourceTracker::Kind::Buffer, sakuraSeedVBO);
+
+    if (oitFBO) glDeleteFramebuffers(1, &oitFBO);
+    if (oitAccumTex) glDeleteTextures(1, &oitAccumTex);
+    if (oitRevealTex) glDeleteTextures(1, &oitRevealTex);
+    if (oitDepthRBO) glDeleteRenderbuffers(1, &oitDepthRBO);
+    if (oitVAO) glDeleteVertexArrays(1, &oitVAO);
+    if (petalQueries[0]) glDeleteQueries(PETAL_QUERY_COUNT, petalQueries);
     if (shadowMap) glDeleteTextures(1, &shadowMap);
     if (shadowFBO) glDeleteFramebuffers(1, &shadowFBO);
+    if (cubemapTex) glDeleteTextures(1, &cubemapTex);
+    if (skyboxVAO) glDeleteVertexArrays(1, &skyboxVAO);
+    if (skyboxVBO) glDeleteBuffers(1, &skyboxVBO);
+    if (sakuraVAO) glDeleteVertexArrays(1, &sakuraVAO);
+    if (sakuraVBO) glDeleteBuffers(1, &sakuraVBO);
+    if (sakuraSeedVBO) glDeleteBuffers(1, &sakuraSeedVBO);
+    oitFBO = oitAccumTex = oitRevealTex = oitDepthRBO = oitVAO = 0;
+    shadowMap = shadowFBO = cubemapTex = skyboxVAO = skyboxVBO = 0;
+    sakuraVAO = sakuraVBO = sakuraSeedVBO = 0;
+
+    myWindow.Delete();
 }
 
 int main(int argc, const char* argv[])
 {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--petals" && i + 1 < argc) {
+            cpuPetalCount = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--gpu-petals" && i + 1 < argc) {
+            gpuPetalCount = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--petal-timing") {
+            petalTimingLog = true;
+        }
+        else if (arg == "--gpu-passes") {
+            gpuPassLog = true;
+        }
+        else if (arg == "--capture" && i + 1 < argc) {
+            capturePrefix = argv[++i];
+        }
+        else if (arg == "--capture-format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "raw")
+                captureFormat = gps::FrameCapture::Format::Raw;
+            else if (format != "png")
+                std::cout << "WARNING: unknown capture format " << format << ", using png" << std::endl;
+        }
+        else if (arg == "--hud") {
+            hud.setVisible(true);
+        }
+        else if (arg == "--gl-stats") {
+            gps::GLStats::setConsoleReport(true);
+        }
+        else if (arg == "--trace-startup" && i + 1 < argc) {
+            traceStartupFile = argv[++i];
+        }
+        else if (arg == "--trace-frames" && i + 3 < argc) {
+            traceFirstFrame = std::max(0, atoi(argv[++i]));
+            traceFrameCount = std::max(1, atoi(argv[++i]));
+            traceFramesFile = argv[++i];
+        }
+        else if (arg == "--bench-profiler") {
+            gps::Profiler::benchmark(1000000);
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--sim-hz" && i + 1 < argc) {
+            simStep = 1.0f / std::max(10, atoi(argv[++i]));
+        }
+        else if (arg == "--single-thread") {
+            singleThreaded = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            workerThreads = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--no-auto-colliders") {
+            autoColliders = false;
+        }
+        else if (arg == "--headless") {
+            headless = true;
+        }
+        else if (arg == "--uncompressed-textures") {
+            gps::Model3D::setTextureCompression(false);
+        }
+        else if (arg == "--no-texture-cache") {
+            gps::TextureCache::setEnabled(false);
+        }
+        else if (arg == "--mip-filter" && i + 1 < argc) {
+            std::string filter = argv[++i];
+            if (filter == "box")
+                gps::MipGenerator::setFilter(gps::MipGenerator::Filter::Box);
+            else if (filter != "kaiser")
+                std::cout << "WARNING: unknown mip filter " << filter << ", using kaiser" << std::endl;
+        }
+        else if (arg == "--frames" && i + 1 < argc) {
+            frameLimit = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--benchmark" && i + 1 < argc) {
+            benchmarkFrames = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--benchmark-csv" && i + 1 < argc) {
+            benchmarkCsv = argv[++i];
+        }
+        else if ((arg == "--golden" || arg == "--golden-update") && i + 1 < argc) {
+            goldenDir = argv[++i];
+            goldenUpdate = arg == "--golden-update";
+        }
+        else if (arg == "--golden-tolerance" && i + 1 < argc) {
+            goldenTolerance = std::max(0.0, atof(argv[++i]) / 100.0);
+        }
+        else if (arg == "--scene" && i + 1 < argc) {
+            scenePath = argv[++i];
+        }
+        else if (arg == "--compile-scene" && i + 2 < argc) {
+            // text scene -> binary scene, which --scene loads without parsing
+            gps::Scene compiled;
+            if (!compiled.load(argv[i + 1]) || !compiled.saveBinary(argv[i + 2]))
+                return EXIT_FAILURE;
+            std::cout << "Scene " << argv[i + 1] << " compiled to " << argv[i + 2] << std::endl;
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-particles") {
+            gps::ParticleSystem::benchmark(100000, 300);
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-petal-sort") {
+            int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+            gps::RadixSort::benchmark({ 10000, 100000 }, maxThreads);
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-collision") {
+            return gps::ColliderGrid::benchmark(10000, 100000) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (arg == "--check-walk") {
+            return checkBridgeWalk();
+        }
+        else if (arg == "--bench-ground") {
+            gps::TriangleBVH::benchmark(512, 100000);
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-transforms") {
+            gps::TransformStore::benchmark(10000, 200);
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-jobs") {
+            gps::JobSystem::benchmark(std::max(1, (int)std::thread::hardware_concurrency()));
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-textures" && i + 1 < argc) {
+            gps::TextureCompressor::benchmark(argv[++i], std::max(1, (int)std::thread::hardware_concurrency()));
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-mips" && i + 1 < argc) {
+            gps::MipGenerator::benchmark(argv[++i], std::max(1, (int)std::thread::hardware_concurrency()));
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--bench-particle-threads") {
+            int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+            gps::ParticleSystem::benchmarkThreads(200000, 200, maxThreads);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    gps::Profiler::setThreadName("main");
+    if (!traceStartupFile.empty())
+        gps::Profiler::beginCapture();
+
+    if (!scene.load(scenePath))
+        return EXIT_FAILURE;
+    initSceneSettings();
+
+    // the simulated clock only drives the single-threaded simulation
+    if (benchmarkFrames > 0) {
+        singleThreaded = true;
+        frameLimit = benchmarkFrames;
+    }
+
+    // still frames: no window, no wall clock, petals that only depend on time
+    if (!goldenDir.empty()) {
+        headless = true;
+        singleThreaded = true;
+        petalMode = PetalMode::Procedural;
+    }
+
+    // nobody can close a headless window
+    if (headless && frameLimit == 0)
+        frameLimit = 600;
+
+    if (workerThreads == 0)
+        workerThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    // the render thread helps while it waits, so it counts as one of the threads
+    jobSystem.start(workerThreads - 1);
+    frameCapture.init(&jobSystem);
+    // with --benchmark this records the same frames on every run
+    if (!capturePrefix.empty())
+        frameCapture.startSequence(capturePrefix, captureFormat);
+    gps::Model3D::setJobSystem(&jobSystem);
+
     try {
         initOpenGLWindow();
     }
@@ -1058,26 +2190,100 @@ int main(int argc, const char* argv[])
     }
 
     initOpenGLState();
-    initModels();
     initShaders();
+    initModels();
+    initColliders();
     glEnable(GL_PROGRAM_POINT_SIZE);
     initSkybox();
     initSakuraPetals();
+    initPetalOIT();
     initShadowMap();
 
     initUniforms();
+    hud.init();
     setWindowCallbacks();
 
     glCheckError();
-    
+
+    if (gpuPassLog || benchmarkFrames > 0 || hud.visible()) {
+        gpuProfiler.init();
+        if (gpuPassLog)
+            gpuProfiler.setLogInterval(gpuPassLogFrames);
+    }
+
+    if (!goldenDir.empty()) {
+        int result = runGoldenViews();
+        cleanup();
+        return result;
+    }
+
+    if (benchmarkFrames > 0) {
+        myWindow.setVSync(false);
+        benchmarkRecorder.init(benchmarkFrames);
+        // profiler frames are counted from here, like the recorder's
+        gpuProfiler.setListener([](long long frame, const std::vector<gps::GpuProfiler::PassTime>& passes) {
+            benchmarkRecorder.setPassTimes(frame, passes);
+        });
+        if (presentationPoints.size() >= 2)
+            togglePresentation();
+    }
+
+    startSimulation();
+
+    if (!traceStartupFile.empty()) {
+        gps::Profiler::endCapture();
+        gps::Profiler::writeChromeTrace(traceStartupFile);
+    }
+
+    int frameCount = 0;
+    double loopStart = glfwGetTime();
+    uint64_t lastFrameStart = 0;
 
     while (!glfwWindowShouldClose(myWindow.getWindow())) {
-        updateDeltaTime();
-        processMovement();
-        renderScene();
+        if (!traceFramesFile.empty()) {
+            if (frameCount == traceFirstFrame)
+                gps::Profiler::beginCapture();
+            else if (frameCount == traceFirstFrame + traceFrameCount) {
+                gps::Profiler::endCapture();
+                gps::Profiler::writeChromeTrace(traceFramesFile);
+            }
+        }
+
+        PROFILE_ZONE("frame");
+        uint64_t frameStart = gps::Profiler::now();
+        if (benchmarkFrames > 0) {
+            benchmarkClock += BENCHMARK_FRAME_TIME;
+            benchmarkRecorder.beginFrame();
+        }
+        gps::Model3D::resetDrawStats();
+        gpuProfiler.beginFrame();
+        gps::GLStats::beginFrame();
+
+        if (singleThreaded) {
+            updateDeltaTime();
+            advanceSimulation();
+        }
+
+        uint64_t renderStart = gps::Profiler::now();
+        frameStates.acquire();
+        renderScene(frameStates.front());
+        gpuProfiler.endFrame();
+        gps::GLStats::endFrame();
+        uint64_t renderEnd = gps::Profiler::now();
+
+        if (benchmarkFrames > 0) {
+            const gps::DrawStats& draws = gps::Model3D::drawStats();
+            gps::BenchmarkCounters counters;
+            counters.meshesDrawn = draws.meshesDrawn;
+            counters.meshesCulled = draws.meshesCulled;
+            counters.triangles = draws.triangles;
+            counters.drawCalls = gps::GLStats::frame.drawCalls;
+            counters.stateChanges = gps::GLStats::frame.stateChanges;
+            benchmarkRecorder.endFrame(counters);
+        }
         if (enterPressed)
         {
-            glm::vec3 pos = myCamera.getPosition();
+            glm::vec3 pos = frameStates.front().current.cameraPos;
 
             std::cout << "Sakura spawn position:\n";
             std::cout << "glm::vec3("
@@ -1088,9 +2294,64 @@ int main(int argc, const char* argv[])
             enterPressed = false;
         }
 
+        frameCapture.capture(myWindow.getFramebuffer(),
+            myWindow.getWindowDimensions().width, myWindow.getWindowDimensions().height);
+
         glfwPollEvents();
-        glfwSwapBuffers(myWindow.getWindow());
+        {
+            PROFILE_ZONE("present");
+            if (headless)
+                glFinish(); // nothing is presented, so wait for the GPU to keep frame times honest
+            else
+                glfwSwapBuffers(myWindow.getWindow());
+        }
         glCheckError();
+
+        if (hud.visible()) {
+            uint64_t presentEnd = gps::Profiler::now();
+            const gps::DrawStats& draws = gps::Model3D::drawStats();
+
+            gps::Hud::Frame stats;
+            stats.frameMs = lastFrameStart ? (frameStart - lastFrameStart) / 1e6 : 0.0;
+            if (singleThreaded)
+                stats.cpu.push_back({ "sim", (renderStart - frameStart) / 1e6 });
+            stats.cpu.push_back({ "render", (renderEnd - renderStart) / 1e6 });
+            stats.cpu.push_back({ "present", (presentEnd - renderEnd) / 1e6 });
+            stats.gpu = gpuProfiler.latest();
+            stats.drawCalls = gps::GLStats::frame.drawCalls;
+            stats.meshesDrawn = draws.meshesDrawn;
+            stats.meshesCulled = draws.meshesCulled;
+            stats.triangles = draws.triangles;
+            gps::ResourceTracker::Totals memory = gps::ResourceTracker::totals();
+            stats.textureBytes = memory.textureBytes;
+            stats.bufferBytes = memory.bufferBytes;
+            hud.update(stats);
+        }
+        lastFrameStart = frameStart;
+
+        if (++frameCount == frameLimit)
+            break;
+    }
+
+    // the window closed inside the traced range
+    if (gps::Profiler::capturing()) {
+        gps::Profiler::endCapture();
+        gps::Profiler::writeChromeTrace(traceFramesFile);
+    }
+
+    if (frameLimit > 0) {
+        double seconds = glfwGetTime() - loopStart;
+        std::cout << frameCount << " frames in " << seconds << " s ("
+            << 1000.0 * seconds / frameCount << " ms/frame)" << std::endl;
+    }
+
+    frameCapture.stopSequence();
+    frameCapture.finish();
+    gpuProfiler.finish();
+    if (benchmarkFrames > 0) {
+        benchmarkRecorder.finish();
+        benchmarkRecorder.writeCsv(benchmarkCsv);
+        benchmarkRecorder.printSummary();
     }
 
     cleanup();
@@ -0,0 +1,18 @@
+#version 410 core
+
+in vec2 fTexCoords;
+in vec4 fVertexColor;
+
+uniform sampler2D font;
+
+out vec4 fColor;
+
+void main()
+{
+    float coverage = texture(font, fTexCoords).r;
+    if (coverage == 0.0)
+        discard;
+
+    // vertex colours are sRGB and the framebuffer encodes to sRGB on write
+    fColor = vec4(pow(fVertexColor.rgb, vec3(2.2)), fVertexColor.a * coverage);
+}
@@ -0,0 +1,18 @@
+#version 410 core
+
+layout(location = 0) in vec2 aPos; // pixels, origin at the top left
+layout(location = 1) in vec2 aTexCoords;
+layout(location = 2) in vec4 aColor;
+
+uniform vec2 screenSize;
+
+out vec2 fTexCoords;
+out vec4 fVertexColor;
+
+void main()
+{
+    vec2 ndc = aPos / screenSize * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    fTexCoords = aTexCoords;
+    fVertexColor = aColor;
+}
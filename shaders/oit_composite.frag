@@ -0,0 +1,21 @@
+#version 410 core
+
+// resolves the weighted blended petals over the opaque scene
+uniform sampler2D accumTexture;
+uniform sampler2D revealTexture;
+
+out vec4 fColor;
+
+void main()
+{
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+
+    float reveal = texelFetch(revealTexture, coord, 0).r;
+    if (reveal >= 0.9999)
+        discard;
+
+    vec4 accum = texelFetch(accumTexture, coord, 0);
+    vec3 average = accum.rgb / max(accum.a, 1e-5);
+
+    fColor = vec4(average, 1.0 - reveal);
+}
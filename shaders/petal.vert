@@ -0,0 +1,37 @@
+#version 410 core
+
+// simulated petals (ParticleSystem), position + normalized life per point
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in float aLife;
+
+uniform mat4 view;
+uniform mat4 projection;
+// first vertex of the buffer region being drawn, so each petal keeps its size
+uniform int regionBase;
+
+out float vAlpha;
+
+float hash(float n)
+{
+    return fract(sin(n) * 43758.5453);
+}
+
+void main()
+{
+    // GPU petals waiting to be born (life < 0) still sit at the origin: clip them
+    if (aLife < 0.0)
+    {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+        vAlpha = 0.0;
+        return;
+    }
+
+    gl_Position = projection * view * vec4(aPos, 1.0);
+
+    gl_PointSize = mix(18.0, 34.0, hash(float(gl_VertexID - regionBase) * 0.618 + 1.3));
+
+    vAlpha =
+        smoothstep(0.0, 0.1, aLife) *
+        smoothstep(1.0, 0.7, aLife);
+}
@@ -0,0 +1,24 @@
+#version 410 core
+
+// weighted blended order-independent transparency, accumulation pass
+in float vAlpha;
+
+layout (location = 0) out vec4 accum;
+layout (location = 1) out float reveal;
+
+void main()
+{
+    vec2 uv = gl_PointCoord * 2.0 - 1.0;
+    float d = length(uv);
+
+    float alpha = smoothstep(1.0, 0.25, d) * vAlpha;
+
+    vec3 color = vec3(1.0, 0.78, 0.88); // sakura pink
+
+    // depth weight (McGuire & Bavoil), favours petals close to the camera
+    float z = gl_FragCoord.z;
+    float weight = clamp(alpha * 3000.0 * pow(1.0 - z * 0.9, 3.0), 0.01, 3000.0);
+
+    accum = vec4(color * alpha, alpha) * weight;
+    reveal = alpha;
+}
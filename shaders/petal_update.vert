@@ -0,0 +1,107 @@
+#version 410 core
+
+// advances one petal per vertex; outputs are captured with transform feedback
+// into the other buffer of the ping-pong pair (GpuParticleSystem)
+layout (location = 0) in vec4 aPosLife;   // xyz = position, w = life (< 0: not born yet)
+layout (location = 1) in vec3 aVelocity;
+
+out vec4 tfPosLife;
+out vec3 tfVelocity;
+
+uniform float uTime;
+uniform float uDeltaTime;
+uniform float uGroundY;
+
+uniform vec3 treePos[3];
+uniform int treeCount;
+
+const int MAX_COLLIDERS = 8;
+uniform vec3 colliderMin[MAX_COLLIDERS];
+uniform vec3 colliderMax[MAX_COLLIDERS];
+uniform int colliderCount;
+
+// same tuning as ParticleSystem.cpp
+const float GRAVITY = 0.55;
+const float AIR_DRAG = 1.8;
+const float CANOPY_BASE = 2.4;
+const float CANOPY_HEIGHT = 0.6;
+const float WIND_X = 1.5;
+const float WIND_Z = 1.2;
+const float FLUTTER = 0.6;
+const float TWO_PI = 6.28318531;
+
+float hash(float n)
+{
+    return fract(sin(n) * 43758.5453);
+}
+
+vec3 spawnPosition(float seed)
+{
+    int tree = min(int(hash(seed) * float(treeCount)), treeCount - 1);
+
+    float angle = hash(seed * 1.7 + 0.31) * TWO_PI;
+    float radius = mix(1.5, 4.8, sqrt(hash(seed * 7.3)));
+
+    return treePos[tree] + vec3(
+        cos(angle) * radius,
+        -CANOPY_BASE + hash(seed * 3.1) * CANOPY_HEIGHT,
+        sin(angle) * radius);
+}
+
+void main()
+{
+    float id = float(gl_VertexID);
+
+    // per-petal constants derived from the id, so they need no storage
+    float lifeRate = 1.0 / mix(20.0, 32.0, hash(id * 0.137 + 0.5));
+    float phase = hash(id * 0.731 + 0.25) * TWO_PI;
+
+    vec3 pos = aPosLife.xyz;
+    float life = aPosLife.w;
+    vec3 vel = aVelocity;
+
+    float newLife = life + lifeRate * uDeltaTime;
+
+    if ((life < 0.0 && newLife >= 0.0) || newLife >= 1.0)
+    {
+        // (re)spawn under a canopy, with a new random seed for each cycle
+        pos = spawnPosition(id * 0.0131 + floor(uTime * 3.0) * 0.77);
+        vel = vec3(0.0);
+        newLife = fract(newLife);
+    }
+    else if (life >= 0.0 && pos.y > uGroundY)
+    {
+        vec2 wind = vec2(sin(uTime * 0.6) * WIND_X, cos(uTime * 0.5) * WIND_Z);
+        vec2 target = wind + FLUTTER * vec2(sin(uTime * 7.0 + phase), cos(uTime * 6.0 + phase));
+
+        float drag = AIR_DRAG * uDeltaTime;
+        vel.xz += drag * (target - vel.xz);
+        vel.y -= GRAVITY * uDeltaTime + drag * vel.y;
+
+        pos += vel * uDeltaTime;
+
+        // settle on the ground
+        if (pos.y < uGroundY)
+        {
+            pos.y = uGroundY;
+            vel = vec3(0.0);
+        }
+
+        // rest on top of colliders
+        for (int i = 0; i < colliderCount; i++)
+        {
+            if (all(greaterThan(pos, colliderMin[i])) && all(lessThan(pos, colliderMax[i])))
+            {
+                pos.y = colliderMax[i].y;
+                vel = vec3(0.0);
+            }
+        }
+    }
+    else
+    {
+        vel = vec3(0.0);
+    }
+
+    tfPosLife = vec4(pos, newLife);
+    tfVelocity = vel;
+}